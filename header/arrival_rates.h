@@ -0,0 +1,48 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "checkpoint.h"
+#include "hospital.h"
+#include "util.h"
+
+namespace zipline
+{
+// Online estimate of how often orders arrive for each hospital: an exponentially decaying count of its past orders,
+// so a rate follows shifts in demand within a few time constants. Recording an order and reading a rate are O(1).
+class ArrivalRates
+{
+   public:
+    ArrivalRates(size_t num_hospitals, Timestamp time_constant)
+        : estimates_(num_hospitals), time_constant_(static_cast<double>(time_constant))
+    {
+    }
+
+    // Counts an order for hospital received at time. An order received before the hospital's latest one counts as
+    // arriving with it.
+    void Record(HospitalId hospital, Timestamp time);
+
+    // (orders per second) expected arrival rate of orders for hospital as of time.
+    double Rate(HospitalId hospital, Timestamp time) const;
+
+    // Writes every hospital's estimate.
+    void Save(CheckpointWriter &writer) const;
+
+    // Replaces the estimates with saved ones. Throws CheckpointError for another number of hospitals.
+    void Load(CheckpointReader &reader);
+
+   private:
+    struct Estimate
+    {
+        double rate{0.0};  // (orders per second) as of time
+        Timestamp time{0};
+    };
+
+    std::vector<Estimate> estimates_;
+    double time_constant_;  // (seconds)
+};
+
+}  // namespace zipline
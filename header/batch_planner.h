@@ -0,0 +1,111 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "hospital.h"
+#include "order.h"
+#include "order_queue.h"
+#include "route_solver.h"
+#include "scheduler_config.h"
+#include "thread_pool.h"
+#include "util.h"
+
+namespace zipline
+{
+// A flight planned at the current tick that has not been committed to the fleet yet.
+struct PlannedFlight
+{
+    int zip_idx;
+    int max_range;             // loops must stay shorter than this
+    std::vector<Order> stops;  // in visiting order
+    int distance;              // loop length from the nest and back
+};
+
+// A pending order the greedy plan left in its queue, which the batch planner may still put on a flight.
+struct LeftoverOrder
+{
+    Order order;
+    OrderHandle handle;  // in the queue of its priority tier
+    Timestamp deadline;  // in that queue; the policy launches it on its own by then at the latest
+    bool taken{false};   // set once a flight has taken it; the caller then removes it from the queue
+};
+
+// Improves all of a nest's flights for one tick together. Starting from the greedy plan, it repeatedly applies the
+// best relocation or swap of a stop between two flights, or the best insertion of a leftover pending order into a
+// flight, measured by priority-weighted time-to-delivery, until no move helps or config.batch_planning.max_moves moves
+// have been applied. Every flight still fits its zip's range, or the longer loop the policy already gave it, and
+// serves emergencies first, and the result only depends on the inputs.
+class BatchPlanner
+{
+   private:
+    struct Move
+    {
+        double delta;
+        size_t flight_a;
+        size_t flight_b;
+        int stop_a;    // stop moved from a to b, or -1
+        int stop_b;    // stop moved from b to a, or -1
+        int leftover;  // leftover order inserted into b instead, or -1
+    };
+
+   public:
+    // Orders left in each tier's queue that are offered to the planner at every tick.
+    static constexpr size_t kMaxLeftoversPerTier = 16;
+
+    // Buffers Improve reuses from tick to tick, so that it does not allocate once they have grown. Keep one per nest,
+    // since nests are planned concurrently.
+    struct Scratch
+    {
+        std::vector<double> costs;                       // per flight
+        std::vector<std::pair<size_t, size_t>> pairs;    // of flights
+        std::vector<Move> moves;                         // best per flight pair, then per flight for a leftover
+    };
+
+    BatchPlanner(const HospitalTable &hospitals, const SchedulerConfig &config)
+        : hospitals_(hospitals),
+          zip_speed_(config.zip_speed),
+          max_packages_(static_cast<size_t>(config.max_packages)),
+          config_(config.batch_planning)
+    {
+    }
+
+    // Candidate moves are evaluated on this pool when set. It must not be the pool the caller is running on.
+    void set_thread_pool(ThreadPool *thread_pool)
+    {
+        thread_pool_ = thread_pool;
+    }
+
+    // Rewrites flights in place, marks the leftovers they took and returns the number of moves applied.
+    size_t Improve(const RouteSolver &routes, HospitalId nest, Timestamp launch_time,
+                   std::vector<PlannedFlight> &flights, std::vector<LeftoverOrder> &leftovers,
+                   Timestamp next_zip_time, Scratch &scratch) const;
+
+   private:
+    const HospitalTable &hospitals_;
+    const int zip_speed_;
+    const size_t max_packages_;
+    const BatchPlanningConfig config_;
+    ThreadPool *thread_pool_{nullptr};
+
+    double Weight(const Order &order) const
+    {
+        return config_.delivery_weight[static_cast<size_t>(order.priority())];
+    }
+
+    double FlightCost(const RouteSolver &routes, HospitalId nest, Timestamp launch_time, std::span<Order> stops,
+                      int max_range, bool reorder) const;
+    double LeftBehindCost(HospitalId nest, Timestamp next_zip_time, const LeftoverOrder &leftover) const;
+    int LoopDistance(HospitalId nest, std::span<const Order> stops) const;
+    Move BestMoveBetween(const RouteSolver &routes, HospitalId nest, Timestamp launch_time,
+                         const std::vector<PlannedFlight> &flights, const std::vector<double> &costs, size_t a,
+                         size_t b) const;
+    Move BestInsertInto(const RouteSolver &routes, HospitalId nest, Timestamp launch_time,
+                        const std::vector<PlannedFlight> &flights, const std::vector<double> &costs,
+                        const std::vector<LeftoverOrder> &leftovers, Timestamp next_zip_time, size_t b) const;
+};
+
+}  // namespace zipline
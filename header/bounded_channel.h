@@ -0,0 +1,104 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace zipline
+{
+// Bounded blocking queue between one or more producers and a consumer that takes everything queued at once. Unlike
+// MpscRing, a full channel makes producers wait, so a fast feed is slowed to the consumer's pace instead of growing
+// memory without bound.
+template <typename T>
+class BoundedChannel
+{
+   public:
+    explicit BoundedChannel(size_t capacity) : capacity_(std::max<size_t>(capacity, 1))
+    {
+    }
+
+    // Blocks while the channel is full. Returns false without queuing value once the channel has been closed.
+    bool Push(const T &value)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return closed_ || values_.size() < capacity_; });
+        if (closed_) return false;
+        values_.push_back(value);
+        peak_size_ = std::max(peak_size_, values_.size());
+        lock.unlock();
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // Wakes every waiting producer and consumer. Values already queued can still be popped.
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    // Waits until something is queued or the channel is closed, then appends everything queued to out, oldest
+    // first and at most max_values of it. Returns false once the channel is closed and drained.
+    bool PopAll(std::vector<T> &out, size_t max_values = std::numeric_limits<size_t>::max())
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return closed_ || !values_.empty(); });
+        return TakeAll(lock, out, max_values);
+    }
+
+    // Same as above, giving up at deadline with nothing popped.
+    template <typename Clock, typename Duration>
+    bool PopAllUntil(std::vector<T> &out, const std::chrono::time_point<Clock, Duration> &deadline,
+                     size_t max_values = std::numeric_limits<size_t>::max())
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait_until(lock, deadline, [this] { return closed_ || !values_.empty(); });
+        return TakeAll(lock, out, max_values);
+    }
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    // Most values ever queued at once.
+    size_t peak_size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return peak_size_;
+    }
+
+   private:
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<T> values_;
+    size_t peak_size_{0};
+    bool closed_{false};
+
+    bool TakeAll(std::unique_lock<std::mutex> &lock, std::vector<T> &out, size_t max_values)
+    {
+        const bool was_full = values_.size() == capacity_;
+        const bool open = !closed_ || !values_.empty();
+        const auto end = values_.begin() + std::min(values_.size(), max_values);
+        out.insert(out.end(), values_.begin(), end);
+        values_.erase(values_.begin(), end);
+        lock.unlock();
+        if (was_full) not_full_.notify_all();
+        return open;
+    }
+};
+
+}  // namespace zipline
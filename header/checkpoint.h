@@ -0,0 +1,96 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "order.h"
+#include "util.h"
+
+namespace zipline
+{
+// Thrown for a checkpoint that is truncated, of another format version or taken with different hospitals or nests.
+class CheckpointError : public std::runtime_error
+{
+   public:
+    using std::runtime_error::runtime_error;
+};
+
+// Where in a run a checkpoint was taken: after the launch tick at time, with the first num_orders orders of the
+// order log queued.
+struct CheckpointInfo
+{
+    Timestamp time{0};
+    uint64_t num_orders{0};
+};
+
+// Writes the checkpoint format: an 8-byte "ZIPCKPT" + version header followed by fixed-width fields in host byte
+// order. Orders are written field by field so the format does not depend on struct padding.
+class CheckpointWriter
+{
+   public:
+    static constexpr uint8_t kVersion = 4;
+
+    // Writes the header.
+    explicit CheckpointWriter(std::ostream &stream);
+
+    template <typename T>
+    void Write(const T value)
+    {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Only plain fields are checkpointed");
+        stream_.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    void WriteOrder(const Order &order)
+    {
+        Write(order.received_time());
+        Write(order.hospital_id());
+        Write(order.priority());
+    }
+
+   private:
+    std::ostream &stream_;
+};
+
+class CheckpointReader
+{
+   public:
+    // Reads and checks the header. Throws CheckpointError if it is not a checkpoint of this version.
+    explicit CheckpointReader(std::istream &stream);
+
+    // Throws CheckpointError if the checkpoint ends early.
+    template <typename T>
+    T Read()
+    {
+        static_assert(std::is_arithmetic_v<T> || std::is_enum_v<T>, "Only plain fields are checkpointed");
+        T value;
+        if (!stream_.read(reinterpret_cast<char *>(&value), sizeof(value)))
+        {
+            throw CheckpointError("Truncated checkpoint");
+        }
+        return value;
+    }
+
+    Order ReadOrder()
+    {
+        const auto received_time = Read<Timestamp>();
+        const auto hospital_id = Read<HospitalId>();
+        const auto priority = Read<Order::Priority>();
+        return Order(received_time, hospital_id, priority);
+    }
+
+    // Throws CheckpointError with message unless condition holds.
+    void Expect(bool condition, const std::string &message) const
+    {
+        if (!condition) throw CheckpointError("Bad checkpoint: " + message);
+    }
+
+   private:
+    std::istream &stream_;
+};
+
+}  // namespace zipline
@@ -0,0 +1,98 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace zipline
+{
+// A malformed input row, reported with the file and 1-based line number it came from.
+class ParseError : public std::runtime_error
+{
+   public:
+    ParseError(const std::filesystem::path &filename, size_t line, const std::string &message);
+
+    size_t line() const
+    {
+        return line_;
+    }
+
+   private:
+    size_t line_;
+};
+
+// Read-only memory mapping of a whole input file.
+class MappedFile
+{
+   public:
+    // Throws std::system_error if the file cannot be opened or mapped.
+    explicit MappedFile(const std::filesystem::path &filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    std::string_view contents() const
+    {
+        return {data_, size_};
+    }
+
+   private:
+    const char *data_{nullptr};
+    size_t size_{0};
+};
+
+// Walks the rows of a mapped CSV file, splitting each into trimmed string_view fields without copying. Blank lines
+// are skipped.
+class CsvReader
+{
+   public:
+    static constexpr size_t kMaxFields = 8;
+
+    explicit CsvReader(const std::filesystem::path &filename) : filename_(filename), file_(filename)
+    {
+    }
+
+    // Advances to the next non-blank row. Returns false at end of file.
+    bool NextRow();
+
+    // Number of fields in the current row.
+    size_t num_fields() const
+    {
+        return num_fields_;
+    }
+
+    std::string_view field(size_t idx) const
+    {
+        return fields_[idx];
+    }
+
+    // 1-based line number of the current row.
+    size_t line() const
+    {
+        return line_;
+    }
+
+    // Throws a ParseError for the current row unless it has exactly num_fields fields.
+    void ExpectFields(size_t num_fields, const char *row_kind) const;
+
+    // Parses a whole field as an integer, throwing a ParseError for the current row otherwise.
+    int ParseInt(size_t idx, const char *field_name) const;
+
+    [[noreturn]] void Fail(const std::string &message) const;
+
+   private:
+    const std::filesystem::path filename_;
+    MappedFile file_;
+    size_t offset_{0};
+    size_t line_{0};
+    std::array<std::string_view, kMaxFields> fields_{};
+    size_t num_fields_{0};
+};
+
+}  // namespace zipline
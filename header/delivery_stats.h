@@ -0,0 +1,67 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+
+#include "flight.h"
+#include "histogram.h"
+#include "order.h"
+#include "util.h"
+
+namespace zipline
+{
+// Streaming delivery KPIs. Every launched flight is folded in as it is reported, using the landing time of each of
+// its packages, so memory use stays constant however long the simulation runs.
+class DeliveryStats
+{
+   public:
+    explicit DeliveryStats(size_t num_zips) : num_zips_(num_zips)
+    {
+    }
+
+    // Adds a launched flight: one delivery per stop, then the round trip.
+    void Record(const Flight &flight);
+
+    // Time-to-delivery (seconds from the order being received to the package landing) of one priority.
+    const Histogram &delivery_times(Order::Priority priority) const
+    {
+        return delivery_times_[static_cast<size_t>(priority)];
+    }
+
+    uint64_t num_flights() const
+    {
+        return num_flights_;
+    }
+
+    uint64_t num_packages() const
+    {
+        return num_packages_;
+    }
+
+    // (meters) total distance flown per package delivered
+    double distance_per_package() const
+    {
+        return num_packages_ ? static_cast<double>(total_distance_) / num_packages_ : 0.0;
+    }
+
+    // Fraction of the fleet's time spent flying, from the first launch until the last zip is back.
+    double zip_utilization() const;
+
+    // Prints a summary table of all KPIs.
+    void Print(std::ostream &out) const;
+
+   private:
+    const size_t num_zips_;
+    std::array<Histogram, Order::kNumPriorities> delivery_times_;
+    uint64_t num_flights_{0};
+    uint64_t num_packages_{0};
+    uint64_t total_distance_{0};  // (meters)
+    uint64_t busy_time_{0};       // (seconds) summed over every flight
+    Timestamp first_launch_time_{0};
+    Timestamp last_return_time_{0};
+};
+
+}  // namespace zipline
@@ -0,0 +1,199 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <thread>
+
+#include "hospital.h"
+#include "mpsc_ring.h"
+#include "order.h"
+#include "util.h"
+
+// Building with -DZIP_DISABLE_EVENT_LOG removes every ZIP_LOG_EVENT call site. The arguments are only named inside
+// sizeof, so they are never evaluated but still count as used.
+#ifdef ZIP_DISABLE_EVENT_LOG
+#define ZIP_LOG_EVENT(log, level, event) \
+    do                                   \
+    {                                    \
+        (void)sizeof(log);               \
+        (void)sizeof(event);             \
+    } while (0)
+#else
+#define ZIP_LOG_EVENT(log, level, event)                       \
+    do                                                         \
+    {                                                          \
+        if ((log) && (log)->enabled(level)) (log)->Log(event); \
+    } while (0)
+#endif
+
+namespace zipline
+{
+enum class LogLevel : uint8_t
+{
+    kDebug = 0,  // per-order events
+    kInfo,       // per-flight and per-tick events
+    kOff,
+};
+
+// What EventLog::Log does with an event when the ring is full.
+enum class LogOverflow : uint8_t
+{
+    kBlock = 0,  // wait for the background thread to make room, so no event is ever lost
+    kDrop,       // drop and count the event, so producers never wait on the log
+};
+
+enum class EventType : uint8_t
+{
+    kOrderQueued = 0,
+    kTickStarted,
+    kFlightLaunched,
+    kStopPlanned,
+    kTickSummary,
+};
+
+// Fixed-size scheduler event record. Field meaning depends on the type:
+//   kOrderQueued:    time = received time, hospital, priority, values = {nest}
+//   kTickStarted:    time = tick
+//   kFlightLaunched: time = launch time, values = {flight number in tick, nest, zip, number of stops}
+//   kStopPlanned:    time = order received time, hospital, priority, values = {flight number in tick}
+//   kTickSummary:    time = tick, values = {free zips, flights launched, emergency pending, resupply pending}
+struct LogEvent
+{
+    EventType type;
+    Order::Priority priority;
+    HospitalId hospital;
+    Timestamp time;
+    int32_t values[4];
+
+    static LogEvent OrderQueued(const Order &order, int nest)
+    {
+        return {EventType::kOrderQueued, order.priority(), order.hospital_id(), order.received_time(), {nest, 0, 0, 0}};
+    }
+
+    static LogEvent TickStarted(Timestamp tick)
+    {
+        return {EventType::kTickStarted, Order::Priority::kUnknown, 0, tick, {0, 0, 0, 0}};
+    }
+
+    static LogEvent FlightLaunched(Timestamp launch_time, int flight_number, int nest, int zip, int num_stops)
+    {
+        return {EventType::kFlightLaunched, Order::Priority::kUnknown, 0, launch_time,
+                {flight_number, nest, zip, num_stops}};
+    }
+
+    static LogEvent StopPlanned(const Order &order, int flight_number)
+    {
+        return {EventType::kStopPlanned, order.priority(), order.hospital_id(), order.received_time(),
+                {flight_number, 0, 0, 0}};
+    }
+
+    static LogEvent TickSummary(Timestamp tick, int free_zips, int num_flights, int emergency_pending,
+                                int resupply_pending)
+    {
+        return {EventType::kTickSummary, Order::Priority::kUnknown, 0, tick,
+                {free_zips, num_flights, emergency_pending, resupply_pending}};
+    }
+};
+
+// Destination for drained events. Sinks only ever run on the event log's background thread.
+class EventSink
+{
+   public:
+    virtual ~EventSink() = default;
+    virtual void Write(const LogEvent &event) = 0;
+    virtual void Flush() = 0;
+};
+
+// The scheduler's classic human-readable console output.
+class TextEventSink : public EventSink
+{
+   public:
+    TextEventSink(std::ostream &stream, const HospitalTable &hospitals) : stream_(stream), hospitals_(hospitals)
+    {
+    }
+    void Write(const LogEvent &event) override;
+    void Flush() override;
+
+   private:
+    std::ostream &stream_;
+    const HospitalTable &hospitals_;
+};
+
+// One JSON object per line.
+class JsonLinesEventSink : public EventSink
+{
+   public:
+    JsonLinesEventSink(std::ostream &stream, const HospitalTable &hospitals) : stream_(stream), hospitals_(hospitals)
+    {
+    }
+    void Write(const LogEvent &event) override;
+    void Flush() override;
+
+   private:
+    std::ostream &stream_;
+    const HospitalTable &hospitals_;
+};
+
+// Raw LogEvent records after an 8-byte header ("ZIPEVT" plus a version byte and the record size).
+class BinaryEventSink : public EventSink
+{
+   public:
+    static constexpr uint8_t kVersion = 1;
+
+    explicit BinaryEventSink(std::ostream &stream);
+    void Write(const LogEvent &event) override;
+    void Flush() override;
+
+   private:
+    std::ostream &stream_;
+};
+
+// Asynchronous event log. Producers push fixed-size records into a lock-free ring, and a background thread drains
+// them into the sink, so formatting and I/O never run on the scheduling path. When the ring is full the producer
+// waits for room by default, so the log is complete; with LogOverflow::kDrop the event is dropped and counted instead.
+class EventLog
+{
+   public:
+    EventLog(std::unique_ptr<EventSink> sink, LogLevel level, LogOverflow overflow = LogOverflow::kBlock,
+             size_t capacity = 1 << 16);
+    ~EventLog();  // drains every queued event, flushes the sink and reports any dropped events on stderr
+
+    EventLog(const EventLog &) = delete;
+    EventLog &operator=(const EventLog &) = delete;
+
+    bool enabled(LogLevel level) const
+    {
+        return level >= level_;
+    }
+
+    // Safe to call from any thread.
+    void Log(const LogEvent &event)
+    {
+        if (ring_.TryPush(event)) return;
+        if (overflow_ == LogOverflow::kDrop) dropped_.fetch_add(1, std::memory_order_relaxed);
+        else PushWhenFree(event);
+    }
+
+    size_t dropped() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    std::unique_ptr<EventSink> sink_;
+    const LogLevel level_;
+    const LogOverflow overflow_;
+    MpscRing<LogEvent> ring_;
+    std::atomic<size_t> dropped_{0};
+    std::atomic<bool> stopping_{false};
+    std::thread drain_thread_;
+
+    void PushWhenFree(const LogEvent &event);
+    void DrainLoop();
+};
+
+}  // namespace zipline
@@ -0,0 +1,86 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "checkpoint.h"
+#include "util.h"
+
+namespace zipline
+{
+enum class RangeClass : uint8_t
+{
+    kFull = 0,
+    kReduced,  // kept to short flights so they are back sooner for incoming emergencies
+    kCount,
+};
+
+// Availability index over the nest's zips. Flying zips sit in a min-heap keyed on return time and free zips in one
+// min-heap of zip indices per range class, so finding the zips that became free at a tick costs O(k log n) for the k
+// zips returning rather than a scan of the whole fleet. All storage is sized once in Initialize.
+class Fleet
+{
+   public:
+    // Creates num_zips free zips; the last num_reduced_range of them are reduced range.
+    void Initialize(int num_zips, int num_reduced_range);
+
+    // Moves every zip that is back by `now` into the free lists.
+    void ReleaseReturned(Timestamp now);
+
+    size_t size() const
+    {
+        return return_times_.size();
+    }
+
+    size_t num_free() const
+    {
+        return free_zips_[0].size() + free_zips_[1].size();
+    }
+
+    bool HasFree() const
+    {
+        return num_free() > 0;
+    }
+
+    RangeClass range_class(int zip_idx) const
+    {
+        return range_classes_[zip_idx];
+    }
+
+    Timestamp return_time(int zip_idx) const
+    {
+        return return_times_[zip_idx];
+    }
+
+    // Removes and returns the lowest-indexed free zip of any range class. At least one zip must be free.
+    int TakeLowestFree();
+
+    // Marks a zip taken from the free lists as flying until return_time.
+    void Launch(int zip_idx, Timestamp return_time);
+
+    // Earliest time at which a zip is back at the nest. When a zip is already free this is at or before the last
+    // ReleaseReturned time.
+    Timestamp NextReturnTime() const;
+
+    // Writes every zip's range class, return time and whether it is flying.
+    void Save(CheckpointWriter &writer) const;
+
+    // Replaces the fleet with a saved one. Throws CheckpointError for a malformed fleet.
+    void Load(CheckpointReader &reader);
+
+   private:
+    using BusyEntry = std::pair<Timestamp, int>;  // (return time, zip index)
+
+    std::vector<Timestamp> return_times_;
+    std::vector<RangeClass> range_classes_;
+    std::vector<BusyEntry> busy_zips_;                                     // min-heap on return time
+    std::vector<int> free_zips_[static_cast<size_t>(RangeClass::kCount)];  // min-heaps on zip index
+    Timestamp last_release_time_{0};
+
+    void PushFree(int zip_idx);
+};
+
+}  // namespace zipline
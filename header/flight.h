@@ -2,28 +2,100 @@
 
 #pragma once
 
-#include <vector>
+#include <array>
+#include <cstdint>
+#include <span>
 
+#include "hospital.h"
 #include "order.h"
 #include "util.h"
 
 namespace zipline
 {
+// Most stops a single flight can carry; SchedulerConfig::max_packages may not exceed it.
+constexpr size_t kMaxFlightStops = 8;
+
+// A launched flight's complete plan: its stops in flying order with the distance of every leg and the time each
+// package lands, so dispatch and tracking never have to re-derive the route. Everything is stored inline, so a
+// Flight is a single fixed-size object with no heap allocation.
 class Flight
 {
    public:
-    Flight(Timestamp launch_time, const std::vector<Order> &orders) : launch_time_(launch_time), orders_(orders)
+    /*
+        Description: Lays out the route nest -> stops[0] -> ... -> stops[n - 1] -> nest. Landing and return times are
+                     rounded up to whole seconds, like the zip return times the scheduler tracks.
+        Arguments:
+            - launch_time: when the zip leaves the nest
+            - stops: orders in the order they are flown; at most kMaxFlightStops
+            - nest_idx: nest the flight launches from and returns to
+            - zip_idx: zip flying it within its nest's fleet
+            - hospitals: leg table for the route
+            - zip_speed: (meters per second)
+    */
+    Flight(Timestamp launch_time, std::span<const Order> stops, size_t nest_idx, int zip_idx,
+           const HospitalTable &hospitals, int zip_speed);
+
+    Timestamp launch_time() const
+    {
+        return launch_time_;
+    }
+
+    // When the zip is back at its nest.
+    Timestamp return_time() const
+    {
+        return return_time_;
+    }
+
+    // Index of the nest the flight launches from.
+    size_t nest() const
+    {
+        return nest_idx_;
+    }
+
+    // Index of the zip flying it within its nest's fleet.
+    int zip() const
+    {
+        return zip_idx_;
+    }
+
+    size_t num_stops() const
+    {
+        return num_stops_;
+    }
+
+    // (meters) whole round trip
+    int total_distance() const
+    {
+        return total_distance_;
+    }
+
+    // Orders in flying order.
+    std::span<const Order> orders() const
+    {
+        return {orders_.data(), num_stops_};
+    }
+
+    // (meters) leg i ends at stop i; the last leg, one past the stops, flies back to the nest.
+    std::span<const int> leg_distances() const
     {
+        return {leg_distances_.data(), num_stops_ + 1u};
     }
 
-    // for debugging
-    const std::vector<Order> &orders() const
+    // Time each stop's package lands, parallel to orders().
+    std::span<const Timestamp> etas() const
     {
-        return orders_;
+        return {etas_.data(), num_stops_};
     }
 
    private:
     Timestamp launch_time_;
-    std::vector<Order> orders_;
+    Timestamp return_time_{0};
+    int total_distance_{0};
+    int zip_idx_;
+    uint16_t nest_idx_;
+    uint8_t num_stops_{0};
+    std::array<Order, kMaxFlightStops> orders_;
+    std::array<int, kMaxFlightStops + 1> leg_distances_{};
+    std::array<Timestamp, kMaxFlightStops> etas_{};
 };
 }  // namespace zipline
@@ -0,0 +1,68 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace zipline
+{
+// Log-linear (HDR-style) histogram of non-negative integer samples in constant memory. Each power of two is split
+// into 32 linear sub-buckets, so any reported percentile is within about 3% of the true sample value.
+class Histogram
+{
+   public:
+    void Record(uint64_t value);
+
+    // Adds every sample recorded in other.
+    void Merge(const Histogram &other);
+
+    void Clear();
+
+    uint64_t count() const
+    {
+        return count_;
+    }
+
+    uint64_t min() const
+    {
+        return count_ ? min_ : 0;
+    }
+
+    uint64_t max() const
+    {
+        return max_;
+    }
+
+    double sum() const
+    {
+        return sum_;
+    }
+
+    double mean() const
+    {
+        return count_ ? sum_ / count_ : 0.0;
+    }
+
+    // Smallest bucket bound at or below which the given fraction (0 to 1) of samples fall, clamped to the max.
+    uint64_t Percentile(double fraction) const;
+
+   private:
+    static constexpr int kSubBucketBits = 6;
+    static constexpr uint64_t kSubBucketCount = uint64_t{1} << kSubBucketBits;
+    static constexpr uint64_t kHalfSubBucketCount = kSubBucketCount / 2;
+    static constexpr size_t kNumBuckets = (64 - kSubBucketBits + 1) * kHalfSubBucketCount + kSubBucketCount;
+
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(size_t index);
+
+    std::array<uint64_t, kNumBuckets> counts_{};
+    uint64_t count_{0};
+    uint64_t min_{std::numeric_limits<uint64_t>::max()};
+    uint64_t max_{0};
+    double sum_{0.0};
+};
+
+}  // namespace zipline
@@ -2,22 +2,42 @@
 
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace zipline
 {
+// Dense index of a hospital in its HospitalTable. Nests are numbered as extra nodes after the last hospital.
+using HospitalId = uint16_t;
+
+class HospitalTable;
+
 class Hospital
 {
    public:
-    Hospital(const std::string &name, int north, int east) : name_(name), north_(north), east_(east)
+    Hospital(HospitalId id, const std::string &name, int north, int east)
+        : id_(id), name_(name), north_(north), east_(east)
     {
     }
 
-    static std::unordered_map<std::string, Hospital> LoadHospitals(const std::filesystem::path &filename);
+    // Loads the hospitals, assigns each one a dense id in file order and precomputes the leg tables. Nests are read
+    // from nests_filename in the same "Name, North, East" format; without one there is a single nest at (0, 0).
+    // Throws ParseError for a malformed row.
+    static HospitalTable LoadHospitals(const std::filesystem::path &filename, int zip_speed,
+                                       const std::filesystem::path &nests_filename = {});
 
-    std::string name() const
+    HospitalId id() const
+    {
+        return id_;
+    }
+
+    const std::string &name() const
     {
         return name_;
     }
@@ -33,9 +53,114 @@ class Hospital
     }
 
    private:
+    const HospitalId id_;
     const std::string name_;
     const int north_;
     const int east_;
 };
 
+// All hospitals served by the nests, plus the distance (meters) and flight time (seconds) of every leg between the
+// nests and the hospitals, so routing never has to recompute a distance.
+class HospitalTable
+{
+   public:
+    // Adds a hospital and returns its id. BuildLegTables must be called again before any leg lookups.
+    HospitalId Add(const std::string &name, int north, int east);
+
+    // Adds a nest. BuildLegTables must be called again before any leg lookups.
+    void AddNest(const std::string &name, int north, int east);
+
+    // Precomputes every nest/hospital leg, adding the default nest at (0, 0) if none were added. Distances are
+    // truncated to whole meters like the rest of the scheduler.
+    void BuildLegTables(int zip_speed);
+
+    // Throws std::out_of_range for an unknown name.
+    HospitalId IdOf(std::string_view name) const
+    {
+        auto id = Find(name);
+        if (!id) throw std::out_of_range("Unknown hospital " + std::string(name));
+        return *id;
+    }
+
+    // Looks a hospital up by name without allocating.
+    std::optional<HospitalId> Find(std::string_view name) const
+    {
+        auto it = ids_.find(name);
+        if (it == ids_.end()) return std::nullopt;
+        return it->second;
+    }
+
+    const Hospital &at(HospitalId id) const
+    {
+        return hospitals_[id];
+    }
+
+    size_t size() const
+    {
+        return hospitals_.size();
+    }
+
+    size_t num_nests() const
+    {
+        return nests_.size();
+    }
+
+    // Node id of a nest in the leg tables.
+    HospitalId nest_id(size_t nest_idx = 0) const
+    {
+        return static_cast<HospitalId>(hospitals_.size() + nest_idx);
+    }
+
+    // Nests are stored as Hospitals whose id is their node id.
+    const Hospital &nest(size_t nest_idx) const
+    {
+        return nests_[nest_idx];
+    }
+
+    int Distance(HospitalId from, HospitalId to) const
+    {
+        return distances_[from * num_nodes_ + to];
+    }
+
+    float FlightTime(HospitalId from, HospitalId to) const
+    {
+        return flight_times_[from * num_nodes_ + to];
+    }
+
+    // Every hospital sorted by distance from the given node (a hospital lists itself first).
+    const std::vector<HospitalId> &NeighborsByDistance(HospitalId from) const
+    {
+        return neighbors_[from];
+    }
+
+    std::vector<Hospital>::const_iterator begin() const
+    {
+        return hospitals_.begin();
+    }
+
+    std::vector<Hospital>::const_iterator end() const
+    {
+        return hospitals_.end();
+    }
+
+   private:
+    // Lets ids_ be searched with a string_view.
+    struct NameHash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const
+        {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+
+    std::vector<Hospital> hospitals_;
+    std::vector<Hospital> nests_;
+    std::unordered_map<std::string, HospitalId, NameHash, std::equal_to<>> ids_;
+    size_t num_nodes_{0};
+    std::vector<int> distances_;
+    std::vector<float> flight_times_;
+    std::vector<std::vector<HospitalId>> neighbors_;
+};
+
 }  // namespace zipline
@@ -0,0 +1,92 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace zipline
+{
+// Bounded lock-free queue for many producers and one consumer. Every slot carries a sequence number that tells
+// producers and the consumer whose turn it is, so neither side ever takes a lock or allocates after construction.
+// TryPush fails instead of blocking when the ring is full.
+template <typename T>
+class MpscRing
+{
+    static_assert(std::is_trivially_copyable_v<T>, "MpscRing holds plain records");
+
+   public:
+    // capacity is rounded up to a power of two.
+    explicit MpscRing(size_t capacity)
+    {
+        size_t rounded = 1;
+        while (rounded < capacity) rounded <<= 1;
+        mask_ = rounded - 1;
+        slots_ = std::make_unique<Slot[]>(rounded);
+        for (size_t i = 0; i < rounded; ++i) slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const
+    {
+        return mask_ + 1;
+    }
+
+    // Safe to call from any number of threads.
+    bool TryPush(const T &value)
+    {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot &slot = slots_[pos & mask_];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    std::memcpy(slot.storage, &value, sizeof(T));
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;  // full
+            }
+            else
+            {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Only one thread may pop.
+    bool TryPop(T &value)
+    {
+        Slot &slot = slots_[head_ & mask_];
+        const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(head_ + 1) < 0) return false;  // empty
+        std::memcpy(&value, slot.storage, sizeof(T));
+        slot.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        head_++;
+        return true;
+    }
+
+   private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];  // raw bytes so T need not be default constructible
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    alignas(64) size_t head_{0};
+};
+
+}  // namespace zipline
@@ -2,36 +2,50 @@
 
 #pragma once
 
+#include <array>
 #include <filesystem>
 #include <iostream>
+#include <iterator>
+#include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
+#include "csv_reader.h"
 #include "hospital.h"
 #include "util.h"
 
 namespace zipline
 {
+// Stable identity of a queued order. ZipScheduler::QueueOrder hands ids out counting up from 0 in the order orders
+// are queued, so when an order log is replayed an order's id is its 0-based row.
+using OrderId = uint64_t;
+
 class Order
 {
    public:
-    enum class Priority
+    enum class Priority : uint8_t
     {
         kUnknown = 0,
         kResupply,
         kEmergency,
     };
 
-    static Priority StringToPriority(const std::string &str);
+    // Every real priority, most urgent first. A new tier is added to the enum, to this list, to the string
+    // conversions and to SchedulerConfig::tiers; the most urgent tier must have the highest value.
+    static constexpr std::array<Priority, 2> kPrioritiesByUrgency{Priority::kEmergency, Priority::kResupply};
+    static constexpr size_t kNumPriorities = static_cast<size_t>(kPrioritiesByUrgency.front()) + 1;
+
+    static Priority StringToPriority(std::string_view str);
     static std::string PriorityToString(Priority priority);
 
-    Order(Timestamp received_time, const Hospital &hospital, Priority priority)
-        : received_time_(received_time), hospital_(hospital), priority_(priority)
+    Order() = default;
+    Order(Timestamp received_time, HospitalId hospital_id, Priority priority)
+        : received_time_(received_time), hospital_id_(hospital_id), priority_(priority)
     {
     }
-    static std::vector<Order> LoadOrders(const std::filesystem::path &filename,
-                                         const std::unordered_map<std::string, Hospital> &hospitals);
+    // Loads every order in the file. Throws ParseError for a malformed or out-of-order row.
+    static std::vector<Order> LoadOrders(const std::filesystem::path &filename, const HospitalTable &hospitals);
 
     Timestamp received_time() const
     {
@@ -43,15 +57,90 @@ class Order
         return priority_;
     }
 
-    const Hospital &hospital() const
+    HospitalId hospital_id() const
     {
-        return hospital_;
+        return hospital_id_;
     }
 
    private:
     Timestamp received_time_{0};
-    Hospital hospital_;
+    HospitalId hospital_id_{0};
     Priority priority_{Priority::kUnknown};
 };
 
+// Streams orders out of a mapped CSV file one row at a time, so long order archives never have to be held in memory.
+// Rows must be in non-decreasing timestamp order.
+class OrderReader
+{
+   public:
+    class Iterator
+    {
+       public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Order;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Order *;
+        using reference = const Order &;
+
+        Iterator() = default;
+        explicit Iterator(OrderReader *reader) : reader_(reader), order_(reader->Next())
+        {
+        }
+
+        const Order &operator*() const
+        {
+            return *order_;
+        }
+
+        const Order *operator->() const
+        {
+            return &*order_;
+        }
+
+        Iterator &operator++()
+        {
+            order_ = reader_->Next();
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const
+        {
+            return order_.has_value() == other.order_.has_value();
+        }
+
+       private:
+        OrderReader *reader_{nullptr};
+        std::optional<Order> order_;
+    };
+
+    OrderReader(const std::filesystem::path &filename, const HospitalTable &hospitals)
+        : reader_(filename), hospitals_(hospitals)
+    {
+    }
+
+    // Parses the next order, or returns nullopt at end of file. Throws ParseError for a malformed or out-of-order row.
+    std::optional<Order> Next();
+
+    // Moves past the next count orders without resolving their hospitals. Returns false if the file ends first.
+    bool Skip(uint64_t count);
+
+    Iterator begin()
+    {
+        return Iterator{this};
+    }
+
+    Iterator end()
+    {
+        return Iterator{};
+    }
+
+   private:
+    CsvReader reader_;
+    const HospitalTable &hospitals_;
+    Timestamp last_timestamp_{0};
+};
+
+// Orders are queued by value in large numbers, so keep them small and free of heap-owning members.
+static_assert(sizeof(Order) <= 8, "Order should stay a few bytes");
+
 }  // namespace zipline
@@ -0,0 +1,77 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "order.h"
+#include "order_queue.h"
+
+namespace zipline
+{
+// Where a queued order is: its nest, its priority tier and its handle in that tier's queue.
+struct OrderLocation
+{
+    uint32_t nest_idx;
+    Order::Priority priority;
+    OrderHandle handle;
+};
+
+// Hash map from OrderId to OrderLocation. Entries live in one flat slot array probed linearly and are erased by
+// shifting the entries after them back, so inserting, finding and erasing never touch the heap allocator once the
+// array has grown to the index's high-water mark.
+class OrderIndex
+{
+   public:
+    size_t size() const
+    {
+        return size_;
+    }
+
+    // Adds an entry for id, or replaces the one already there.
+    void Insert(OrderId id, const OrderLocation &location);
+
+    // Entry for id, or nullptr if there is none. Valid until the index is next changed.
+    OrderLocation *Find(OrderId id);
+
+    void Erase(OrderId id);
+
+    // Erases every entry for which remove(id, location) returns true.
+    template <typename Predicate>
+    void EraseIf(const Predicate &remove)
+    {
+        for (size_t slot = 0; slot < slots_.size();)
+        {
+            // an erased slot takes in a later entry, so look at the same slot again
+            if (slots_[slot].id != kEmptySlot && remove(slots_[slot].id, slots_[slot].location)) EraseSlot(slot);
+            else ++slot;
+        }
+    }
+
+    // Erases every entry, keeping the slot array for reuse.
+    void Clear();
+
+   private:
+    static constexpr OrderId kEmptySlot = std::numeric_limits<OrderId>::max();
+    static constexpr size_t kMinSlots = 64;
+
+    struct Slot
+    {
+        OrderId id{kEmptySlot};
+        OrderLocation location{};
+    };
+
+    std::vector<Slot> slots_;  // power-of-two many, at most half of them used
+    size_t size_{0};
+    unsigned shift_{64};  // 64 - log2(slots_.size()), for Fibonacci hashing
+
+    size_t HomeSlot(OrderId id) const;
+    size_t FindSlot(OrderId id) const;
+    void EraseSlot(size_t slot);
+    void Grow();
+};
+
+}  // namespace zipline
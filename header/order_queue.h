@@ -0,0 +1,183 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "checkpoint.h"
+#include "hospital.h"
+#include "order.h"
+#include "util.h"
+
+namespace zipline
+{
+// Stable reference to an order held in an OrderQueue. Valid until the order is removed, after which the slot may be
+// recycled for another order; Holds tells the two apart.
+using OrderHandle = uint32_t;
+constexpr OrderHandle kInvalidOrderHandle = std::numeric_limits<OrderHandle>::max();
+
+// Pending orders of a single priority tier, bucketed by destination hospital. Orders live in a contiguous arena
+// indexed by an intrusive binary min-heap on their deadline (received time plus the tier's time to deadline unless
+// set otherwise, ties by sequence number), and are threaded onto their hospital's bucket in sequence order. Pushing,
+// removing or re-dating an order at any position is O(log n), plus the orders it is pushed behind in its bucket when
+// it is older than them, and freed slots are recycled, so once the arena has grown to the backlog's high-water mark
+// pushing and popping never touches the heap allocator.
+class OrderQueue
+{
+   public:
+    // Most orders MostUrgent returns at once.
+    static constexpr size_t kMaxMostUrgent = 32;
+
+    explicit OrderQueue(size_t num_hospitals, Timestamp time_to_deadline = 0)
+        : buckets_(num_hospitals), time_to_deadline_(time_to_deadline)
+    {
+    }
+
+    // Pre-sizes the arena so that up to `capacity` pending orders never allocate.
+    void Reserve(size_t capacity);
+
+    // Pushes an order with the next sequence number, so orders tie in the order they were pushed.
+    OrderHandle Push(const Order &order);
+
+    // Pushes an order with a caller-chosen sequence number, such as its OrderId, which should grow with arrival so
+    // equal deadlines still tie oldest first. The order takes its place in its hospital's bucket by sequence number,
+    // so an order moved from another tier is still the oldest it was. The deadline defaults to the tier's.
+    OrderHandle Push(const Order &order, uint64_t seq);
+    OrderHandle Push(const Order &order, uint64_t seq, Timestamp deadline);
+
+    bool empty() const
+    {
+        return heap_.empty();
+    }
+
+    size_t size() const
+    {
+        return heap_.size();
+    }
+
+    const Order &at(OrderHandle handle) const
+    {
+        return nodes_[handle].order;
+    }
+
+    uint64_t sequence(OrderHandle handle) const
+    {
+        return nodes_[handle].seq;
+    }
+
+    Timestamp deadline(OrderHandle handle) const
+    {
+        return nodes_[handle].deadline;
+    }
+
+    // True if handle still refers to the pending order pushed with sequence number seq, rather than to an order
+    // that has since been removed or to another order recycled into its slot.
+    bool Holds(OrderHandle handle, uint64_t seq) const
+    {
+        return handle < nodes_.size() && nodes_[handle].seq == seq && nodes_[handle].heap_index < heap_.size() &&
+               heap_[nodes_[handle].heap_index] == handle;
+    }
+
+    // Handles of every pending order, in no particular order.
+    const std::vector<OrderHandle> &handles() const
+    {
+        return heap_;
+    }
+
+    // Writes the handles of the (at most kMaxMostUrgent) most urgent orders to handles, most urgent first, and returns
+    // how many there were. Unlike the first entries of handles(), the result only depends on the pending orders and
+    // not on the order they were pushed and removed in, so it survives a checkpoint. O(handles.size()^2).
+    size_t MostUrgent(std::span<OrderHandle> handles) const;
+
+    // Handle of the most urgent order in the queue, or kInvalidOrderHandle when empty.
+    OrderHandle front_handle() const
+    {
+        return heap_.empty() ? kInvalidOrderHandle : heap_.front();
+    }
+
+    // Most urgent order in the queue: the earliest deadline, oldest first. The queue must not be empty.
+    const Order &front() const
+    {
+        return nodes_[heap_.front()].order;
+    }
+
+    // Deadline of the most urgent order. The queue must not be empty.
+    Timestamp front_deadline() const
+    {
+        return nodes_[heap_.front()].deadline;
+    }
+
+    bool HasOrdersFor(HospitalId hospital) const
+    {
+        return buckets_[hospital].head != kInvalidOrderHandle;
+    }
+
+    // Oldest order for the given hospital, whose bucket must not be empty.
+    const Order &PeekFrom(HospitalId hospital) const
+    {
+        return nodes_[buckets_[hospital].head].order;
+    }
+
+    // Removes and returns the most urgent order in the queue.
+    Order PopFront();
+
+    // Removes and returns the oldest order for the given hospital, whose bucket must not be empty.
+    Order PopFrom(HospitalId hospital);
+
+    // Removes and returns the order with the given handle.
+    Order Remove(OrderHandle handle);
+
+    // Moves a pending order to a new deadline, keeping its place in its hospital's bucket.
+    void SetDeadline(OrderHandle handle, Timestamp deadline);
+
+    // Returns the closest hospital to `from` that has a pending order, breaking distance ties by arrival order,
+    // or nullopt when the queue is empty. Adds the number of hospitals examined to num_scanned if given.
+    std::optional<HospitalId> NearestHospital(const HospitalTable &hospitals, HospitalId from,
+                                              size_t *num_scanned = nullptr) const;
+
+    // Writes the pending orders oldest first, with their sequence numbers and deadlines.
+    void Save(CheckpointWriter &writer) const;
+
+    // Replaces the queue's contents with saved orders. Throws CheckpointError for an order to an unknown hospital.
+    void Load(CheckpointReader &reader);
+
+   private:
+    struct Node
+    {
+        Order order;
+        uint64_t seq;
+        Timestamp deadline;
+        uint32_t heap_index;
+        OrderHandle bucket_prev;  // same-hospital list in sequence order
+        OrderHandle bucket_next;  // also links the free list
+    };
+
+    struct Bucket
+    {
+        OrderHandle head{kInvalidOrderHandle};
+        OrderHandle tail{kInvalidOrderHandle};
+    };
+
+    bool MoreUrgent(OrderHandle a, OrderHandle b) const
+    {
+        const Node &x = nodes_[a];
+        const Node &y = nodes_[b];
+        return x.deadline < y.deadline || (x.deadline == y.deadline && x.seq < y.seq);
+    }
+
+    void SiftUp(uint32_t index);
+    void SiftDown(uint32_t index);
+
+    std::vector<Node> nodes_;
+    std::vector<OrderHandle> heap_;
+    std::vector<Bucket> buckets_;
+    Timestamp time_to_deadline_;
+    OrderHandle free_head_{kInvalidOrderHandle};
+    uint64_t next_seq_{0};
+};
+
+}  // namespace zipline
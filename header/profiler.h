@@ -0,0 +1,213 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+#include "histogram.h"
+#include "util.h"
+
+// Building with -DZIP_DISABLE_PROFILING removes every ZIP_PROFILE_* call site, like ZIP_DISABLE_EVENT_LOG does for
+// the event log. Otherwise a call site costs one null check while no profiler is attached.
+#define ZIP_PROFILE_CONCAT_INNER(a, b) a##b
+#define ZIP_PROFILE_CONCAT(a, b) ZIP_PROFILE_CONCAT_INNER(a, b)
+#ifdef ZIP_DISABLE_PROFILING
+#define ZIP_PROFILE_SCOPE(profiler, phase) (void)sizeof(profiler)
+#define ZIP_PROFILE_TICK(profiler, time) (void)sizeof(profiler)
+#define ZIP_PROFILE_COUNT(profiler, counter, value) \
+    do                                              \
+    {                                               \
+        (void)sizeof(profiler);                     \
+        (void)sizeof(value);                        \
+    } while (0)
+#else
+#define ZIP_PROFILE_SCOPE(profiler, phase) \
+    ::zipline::ScopedTimer ZIP_PROFILE_CONCAT(zip_profile_scope_, __LINE__)(profiler, phase)
+#define ZIP_PROFILE_TICK(profiler, time) \
+    ::zipline::ScopedTick ZIP_PROFILE_CONCAT(zip_profile_tick_, __LINE__)(profiler, time)
+#define ZIP_PROFILE_COUNT(profiler, counter, value)      \
+    do                                                   \
+    {                                                    \
+        if (profiler) (profiler)->Count(counter, value); \
+    } while (0)
+#endif
+
+namespace zipline
+{
+// Timed sections of a scheduler tick.
+enum class ProfilePhase : uint8_t
+{
+    kTick,         // a whole LaunchFlights call
+    kDrainIntake,  // moving queued orders into the nests
+    kPlanNest,     // planning one nest
+    kFreeZips,     // releasing returned zips
+    kPickAnchor,   // choosing the order a flight is built around
+    kBuildRoute,   // growing a flight from its anchor
+    kQueueErase,   // taking orders out of their queue
+    kBatchPlan,    // improving a nest's flights together
+    kCommit,       // launching planned flights from the fleet
+    kCount
+};
+
+// Sampled quantities, one sample per flight, tick or nest as noted.
+enum class ProfileCounter : uint8_t
+{
+    kCandidatesScanned,  // per flight: hospitals examined while looking for its stops
+    kStopsPerFlight,     // per flight
+    kFlightsPerTick,     // per tick
+    kOrdersDrained,      // per tick: orders moved from the intake into the nests
+    kQueueDepth,         // per nest and tick: orders still pending after planning
+    kCount
+};
+
+// Collects per-phase latencies and counters into histograms, a Chrome trace of every timed section and the ticks
+// that ran over budget. Any thread may record: each one writes its own buffer, and the buffers are only merged for
+// reporting.
+class Profiler
+{
+   public:
+#ifdef ZIP_DISABLE_PROFILING
+    static constexpr bool kCompiledIn = false;
+#else
+    static constexpr bool kCompiledIn = true;
+#endif
+
+    // tick_budget: ticks that take longer are listed in the summary. max_trace_events bounds the trace's memory;
+    // sections past it are still counted in the histograms.
+    explicit Profiler(std::chrono::nanoseconds tick_budget, size_t max_trace_events = size_t{1} << 20);
+    ~Profiler();
+
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
+    // Nanoseconds since the profiler was created.
+    uint64_t Now() const
+    {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count());
+    }
+
+    void RecordPhase(ProfilePhase phase, uint64_t start_ns, uint64_t end_ns);
+    void Count(ProfileCounter counter, uint64_t value);
+
+    // Brackets one LaunchFlights call. Called from the launching thread.
+    void BeginTick();
+    void EndTick(Timestamp time, uint64_t start_ns, uint64_t end_ns);
+
+    // Per-phase latency and counter percentiles, then the slowest ticks over budget with where their time went.
+    // Called once recording threads are idle.
+    void PrintSummary(std::ostream &stream) const;
+
+    // Every recorded section as Chrome trace-event JSON, for chrome://tracing or Perfetto.
+    void WriteChromeTrace(std::ostream &stream) const;
+
+   private:
+    static constexpr size_t kNumPhases = static_cast<size_t>(ProfilePhase::kCount);
+    static constexpr size_t kNumCounters = static_cast<size_t>(ProfileCounter::kCount);
+    static constexpr size_t kMaxSlowTicks = 10;
+    static constexpr size_t kMaxPhasesPerTick = 4;  // shown for each slow tick, the costliest first
+
+    struct TraceEvent
+    {
+        uint64_t start_ns;
+        uint64_t duration_ns;
+        ProfilePhase phase;
+        Timestamp tick_time;  // scheduler time of a kTick section
+    };
+
+    // One recording thread's samples; its mutex is only ever contended while reporting.
+    struct ThreadBuffer
+    {
+        std::mutex mutex;
+        size_t thread_idx{0};
+        std::array<Histogram, kNumPhases> phases;
+        std::array<Histogram, kNumCounters> counters;
+        std::vector<TraceEvent> events;
+    };
+
+    // A tick over budget and the time its phases took, summed over every thread that planned for it.
+    struct SlowTick
+    {
+        Timestamp time;
+        uint64_t duration_ns;
+        std::array<uint64_t, kNumPhases> phase_ns;
+    };
+
+    const std::chrono::steady_clock::time_point start_;
+    const uint64_t tick_budget_ns_;
+    const size_t max_trace_events_;
+    const uint64_t instance_id_;
+    std::atomic<size_t> num_trace_events_{0};
+    std::atomic<size_t> num_dropped_events_{0};
+
+    mutable std::mutex buffers_mutex_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+    // launching thread only
+    std::array<std::atomic<uint64_t>, kNumPhases> tick_phase_ns_{};
+    size_t num_ticks_{0};
+    size_t num_slow_ticks_{0};
+    std::vector<SlowTick> slowest_ticks_;  // min-heap on duration, at most kMaxSlowTicks
+
+    ThreadBuffer &LocalBuffer();
+    void Record(ProfilePhase phase, uint64_t start_ns, uint64_t end_ns, Timestamp tick_time);
+};
+
+// Times the enclosing scope into a profiler phase; does nothing without a profiler.
+class ScopedTimer
+{
+   public:
+    ScopedTimer(Profiler *profiler, ProfilePhase phase)
+        : profiler_(profiler), phase_(phase), start_ns_(profiler ? profiler->Now() : 0)
+    {
+    }
+
+    ~ScopedTimer()
+    {
+        if (profiler_) profiler_->RecordPhase(phase_, start_ns_, profiler_->Now());
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+   private:
+    Profiler *const profiler_;
+    const ProfilePhase phase_;
+    const uint64_t start_ns_;
+};
+
+// Times the enclosing scope as the tick at time.
+class ScopedTick
+{
+   public:
+    ScopedTick(Profiler *profiler, Timestamp time) : profiler_(profiler), time_(time)
+    {
+        if (!profiler_) return;
+        profiler_->BeginTick();
+        start_ns_ = profiler_->Now();
+    }
+
+    ~ScopedTick()
+    {
+        if (profiler_) profiler_->EndTick(time_, start_ns_, profiler_->Now());
+    }
+
+    ScopedTick(const ScopedTick &) = delete;
+    ScopedTick &operator=(const ScopedTick &) = delete;
+
+   private:
+    Profiler *const profiler_;
+    const Timestamp time_;
+    uint64_t start_ns_{0};
+};
+
+}  // namespace zipline
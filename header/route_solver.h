@@ -0,0 +1,79 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "hospital.h"
+#include "order.h"
+
+namespace zipline
+{
+// Largest flight the exact solver handles; bigger flights keep the order they were built in.
+constexpr size_t kMaxRouteStops = 4;
+
+// Visiting order of a flight's stops and the length of the loop from the nest and back.
+struct Route
+{
+    int distance{0};
+    uint8_t num_stops{0};
+    std::array<uint8_t, kMaxRouteStops> stop_order{};  // indexes into the stops passed to Solve
+};
+
+// Exact shortest-loop solver for the handful of stops a zip carries. Every visiting order is enumerated, with
+// emergency stops always served before resupply stops, and results are memoized by (nest, stop hospitals and
+// priorities) so repeated combinations across ticks cost one hash lookup. The memo is a fixed-size direct-mapped
+// table allocated up front, a new combination overwriting whichever one shared its slot, so solving never touches the
+// heap allocator. Not thread safe; use one per nest.
+class RouteSolver
+{
+   public:
+    explicit RouteSolver(const HospitalTable &hospitals) : hospitals_(hospitals), cache_(kNumCacheSlots)
+    {
+    }
+
+    // Shortest loop from the nest through every stop. stops.size() must be at most kMaxRouteStops.
+    Route Solve(HospitalId nest, std::span<const Order> stops);
+
+    // Same as Solve without touching the cache, so it can be called from several threads at once.
+    Route SolveUncached(HospitalId nest, std::span<const Order> stops) const;
+
+    // Number of routes currently memoized.
+    size_t cache_size() const
+    {
+        return num_cached_;
+    }
+
+   private:
+    static constexpr size_t kNumCacheSlots = 1 << 15;  // power of two; bounds memory for very large hospital sets
+
+    // Nest followed by the stops sorted by (priority, hospital); each stop packs its emergency flag above its
+    // HospitalId.
+    using RouteKey = std::array<uint32_t, kMaxRouteStops + 1>;
+
+    struct CacheSlot
+    {
+        bool filled{false};
+        RouteKey key{};
+        Route route;
+    };
+
+    const HospitalTable &hospitals_;
+    std::vector<CacheSlot> cache_;
+    size_t num_cached_{0};
+
+    static size_t HashKey(const RouteKey &key);
+
+    // Builds the canonical key for stops; sorted[i] is the caller's index of the i-th stop in the key.
+    static RouteKey MakeKey(HospitalId nest, std::span<const Order> stops, std::array<uint8_t, kMaxRouteStops> &sorted);
+
+    Route SolveKey(HospitalId nest, const RouteKey &key, size_t num_stops) const;
+
+    template <size_t N>
+    Route SolveExact(HospitalId nest, const RouteKey &key) const;
+};
+
+}  // namespace zipline
@@ -0,0 +1,134 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <array>
+#include <stdexcept>
+#include <string>
+
+#include "flight.h"
+#include "order.h"
+#include "util.h"
+
+namespace zipline
+{
+// How the orders of one priority tier are launched. A tier's flights anchor on its most urgent order and then fill up
+// with the nearest orders of every tier, most urgent tier first.
+struct PriorityTier
+{
+    Timestamp time_to_deadline{0};  // (seconds) orders are launched by received time + this at the latest...
+    size_t min_batch{1};            // ...or as soon as this many of the tier's orders are waiting
+    int max_flights_per_tick{0};    // flights the tier may start per nest per tick; 0 for every free zip
+    bool reduced_range{false};      // reduced range zips keep to reduced_range_time on the tier's flights
+};
+
+// Parameters of the lookahead policy, which may hold a due flight with room to spare for the orders it expects to
+// join it soon. The defaults did best of a sweep over generated days (zip_evaluate --variant-policy=lookahead); on
+// the recorded day alone the policy still flies more flights and delivers resupply later than greedy.
+struct LookaheadConfig
+{
+    Timestamp rate_time_constant{60 * 60};  // (seconds) how quickly per-hospital arrival rates forget old orders
+    size_t max_neighbors{16};               // hospitals around a flight's anchor whose orders could join it
+
+    // Indexed by Order::Priority: how long past its deadline a tier's flight may be held, and what a second of
+    // waiting costs for one of its orders, in seconds of zip time.
+    std::array<Timestamp, Order::kNumPriorities> max_hold{0, 10 * 60, 2 * 60};
+    std::array<double, Order::kNumPriorities> wait_cost{0.0, 1.0, 4.0};
+};
+
+// Parameters of batch planning, which improves all of a nest's flights for a tick together by local search, scoring
+// a flight by its stops' priority-weighted time to delivery.
+struct BatchPlanningConfig
+{
+    size_t max_moves{0};  // improvements applied per nest per tick; 0 turns batch planning off
+
+    // Indexed by Order::Priority: what a second of an order's time to delivery costs. An emergency second counts as
+    // much as four resupply seconds.
+    std::array<double, Order::kNumPriorities> delivery_weight{0.0, 1.0, 4.0};
+    double return_time_weight{0.1};  // per second of a zip's time away from the nest; favours zips home sooner
+};
+
+// Fleet and policy parameters of a scheduler. The defaults are the original operating parameters; anything else is a
+// what-if scenario that no longer needs a rebuild.
+struct SchedulerConfig
+{
+    int num_zips{10};                          // per nest
+    int max_range{160 * 1000};                 // (meters) 160 km
+    int max_packages{3};                       // per flight
+    int zip_speed{30};                         // (meters per second)
+    int num_zips_reduced_range{2};             // zips per nest that only fly short resupply loops
+    Timestamp reduced_range_time{45 * 60};     // (seconds) longest round trip of a reduced range zip
+    int nest_load_penalty{5 * 1000};           // (meters) charged per pending order per zip when picking a nest
+    Timestamp time_between_launches{60};       // (seconds)
+    size_t intake_capacity{1 << 16};           // orders QueueOrder can buffer lock-free between two ticks
+
+    // Indexed by Order::Priority. Emergencies take every free zip right away; resupply waits for a batch of five
+    // or for the oldest order to have waited 15 minutes, and starts one flight per tick.
+    std::array<PriorityTier, Order::kNumPriorities> tiers{
+        PriorityTier{},                        // kUnknown, never queued
+        PriorityTier{15 * 60, 5, 1, true},     // kResupply
+        PriorityTier{0, 1, 0, false},          // kEmergency
+    };
+
+    LookaheadConfig lookahead;
+    BatchPlanningConfig batch_planning;
+
+    PriorityTier &tier(Order::Priority priority)
+    {
+        return tiers[static_cast<size_t>(priority)];
+    }
+
+    const PriorityTier &tier(Order::Priority priority) const
+    {
+        return tiers[static_cast<size_t>(priority)];
+    }
+
+    // (meters) max distance of a reduced range zip, so that it is back within reduced_range_time
+    int reduced_range() const
+    {
+        return static_cast<int>(reduced_range_time) * zip_speed;
+    }
+
+    // Throws std::invalid_argument if the parameters cannot describe a working fleet.
+    void Validate() const
+    {
+        if (num_zips <= 0) throw std::invalid_argument("Need at least one zip per nest");
+        if (num_zips_reduced_range < 0) throw std::invalid_argument("Reduced range zip count must not be negative");
+        if (max_range <= 0) throw std::invalid_argument("Max range must be positive");
+        if (max_packages <= 0 || static_cast<size_t>(max_packages) > kMaxFlightStops)
+        {
+            throw std::invalid_argument("Max packages must be between 1 and " + std::to_string(kMaxFlightStops));
+        }
+        if (zip_speed <= 0) throw std::invalid_argument("Zip speed must be positive");
+        if (time_between_launches <= 0) throw std::invalid_argument("Time between launches must be positive");
+        if (intake_capacity == 0) throw std::invalid_argument("Intake capacity must be positive");
+        for (const auto priority : Order::kPrioritiesByUrgency)
+        {
+            const PriorityTier &t = tier(priority);
+            const std::string name = Order::PriorityToString(priority);
+            if (t.time_to_deadline < 0) throw std::invalid_argument(name + " time to deadline must not be negative");
+            if (t.min_batch == 0) throw std::invalid_argument(name + " batch size must be positive");
+            if (t.max_flights_per_tick < 0)
+            {
+                throw std::invalid_argument(name + " flights per tick must not be negative");
+            }
+            const size_t i = static_cast<size_t>(priority);
+            if (lookahead.max_hold[i] < 0) throw std::invalid_argument(name + " max hold must not be negative");
+            if (!(lookahead.wait_cost[i] >= 0)) throw std::invalid_argument(name + " wait cost must not be negative");
+            if (!(batch_planning.delivery_weight[i] >= 0))
+            {
+                throw std::invalid_argument(name + " delivery weight must not be negative");
+            }
+        }
+        if (!(batch_planning.return_time_weight >= 0))
+        {
+            throw std::invalid_argument("Return time weight must not be negative");
+        }
+        if (lookahead.rate_time_constant <= 0)
+        {
+            throw std::invalid_argument("Arrival rate time constant must be positive");
+        }
+    }
+};
+
+}  // namespace zipline
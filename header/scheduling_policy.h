@@ -0,0 +1,139 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <concepts>
+#include <optional>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "arrival_rates.h"
+#include "fleet.h"
+#include "hospital.h"
+#include "order.h"
+#include "order_queue.h"
+#include "profiler.h"
+#include "route_solver.h"
+#include "scheduler_config.h"
+#include "util.h"
+
+namespace zipline
+{
+// What a scheduling policy sees of one nest while planning a tick: its pending orders (indexed by Order::Priority),
+// its fleet, its route cache and the arrival rates of the orders it has been assigned. Policies take orders out of
+// the queues as they put them on flights, and report what they did to the profiler, if any.
+struct NestContext
+{
+    const HospitalTable &hospitals;
+    const SchedulerConfig &config;
+    HospitalId node;
+    std::vector<OrderQueue> &queues;
+    const Fleet &fleet;
+    RouteSolver &routes;
+    const ArrivalRates &arrival_rates;
+    Profiler *profiler{nullptr};
+    size_t num_scanned{0};                   // hospitals examined by nearest-order searches
+    OrderHandle anchor{kInvalidOrderHandle};  // set by a ShouldLaunch that already chose the flight's anchor
+
+    OrderQueue &queue(Order::Priority priority) const
+    {
+        return queues[static_cast<size_t>(priority)];
+    }
+};
+
+// A scheduling policy decides, for one nest at one tick and one priority tier at a time:
+//   - ShouldLaunch: whether the tier, which has pending orders and a free zip, starts another flight; num_flights is
+//     how many it already started this tick (launch gating)
+//   - FlightRange: how far the given zip may fly on the tier's flight
+//   - PickAnchor: which order the flight is built around, taking it out of its queue
+//   - BuildRoute: which other orders join the anchor (the only entry in stops) within max_range and the package
+//     limit, and in which order they are flown; returns the loop distance
+// ZipScheduler calls these on the concrete policy type, so none of them is a virtual call.
+template <typename P>
+concept SchedulingPolicy = requires(const P &policy, NestContext &nest, Order::Priority tier, int num_flights,
+                                    Timestamp time, int zip_idx, std::vector<Order> &stops, int max_range) {
+    { P::kName } -> std::convertible_to<std::string_view>;
+    { policy.ShouldLaunch(nest, tier, num_flights, time) } -> std::same_as<bool>;
+    { policy.FlightRange(nest, tier, zip_idx) } -> std::same_as<int>;
+    { policy.PickAnchor(nest, tier) } -> std::same_as<Order>;
+    { policy.BuildRoute(nest, stops, max_range) } -> std::same_as<int>;
+};
+
+// The original policy. Tiers launch by the batching rules in SchedulerConfig::tiers and anchor on their most urgent
+// order; flights grow by the nearest order that still fits, most urgent tier first, and are flown in the shortest
+// order that serves emergencies first.
+class GreedyPolicy
+{
+   public:
+    static constexpr std::string_view kName = "greedy";
+
+    bool ShouldLaunch(NestContext &nest, Order::Priority tier, int num_flights, Timestamp current_time) const;
+    int FlightRange(NestContext &nest, Order::Priority tier, int zip_idx) const;
+    Order PickAnchor(NestContext &nest, Order::Priority tier) const;
+    int BuildRoute(NestContext &nest, std::vector<Order> &stops, int max_range) const;
+
+   protected:
+    // Position of a flight being grown by nearest-next steps.
+    struct RouteState
+    {
+        HospitalId curr_node;  // last stop so far
+        int curr_dist;         // (meters) from the nest through every stop so far
+        int return_dist;       // (meters) from the last stop back to the nest
+    };
+
+    std::optional<Order> TakeNearestInQueue(NestContext &nest, std::vector<Order> &stops, RouteState &state,
+                                            int max_range, OrderQueue &orders) const;
+
+    // Grows stops one order at a time with next_stop, then picks the visiting order. Returns the loop distance.
+    template <typename NextStop>
+    int GrowRoute(NestContext &nest, std::vector<Order> &stops, NextStop next_stop) const;
+};
+
+// Greedy launches and anchors, but flights grow by the nearest order that fits whatever its tier, so an emergency
+// flight picks up a resupply order next door before an emergency across the district.
+class NearestNeighborPolicy : public GreedyPolicy
+{
+   public:
+    static constexpr std::string_view kName = "nearest";
+
+    int BuildRoute(NestContext &nest, std::vector<Order> &stops, int max_range) const;
+};
+
+// Greedy routes, but a due flight with room to spare may be held for the orders expected to join it. Each tick the
+// policy weighs launching now against holding for every candidate anchor, predicting arrivals around it from the
+// nest's arrival rates, and anchors the tier's next flight on its most urgent order that is not worth holding. A hold
+// lasts only while it keeps paying off and at most the tier's SchedulerConfig::lookahead.max_hold. A decision looks
+// at a bounded number of orders and hospitals, whatever the backlog.
+class LookaheadPolicy : public GreedyPolicy
+{
+   public:
+    static constexpr std::string_view kName = "lookahead";
+
+    // A tier's most urgent orders considered as anchors each flight.
+    static constexpr size_t kMaxAnchorCandidates = 8;
+    static_assert(kMaxAnchorCandidates <= OrderQueue::kMaxMostUrgent, "OrderQueue::MostUrgent returns fewer");
+
+    bool ShouldLaunch(NestContext &nest, Order::Priority tier, int num_flights, Timestamp current_time) const;
+    Order PickAnchor(NestContext &nest, Order::Priority tier) const;
+
+   private:
+    OrderHandle FindAnchor(NestContext &nest, Order::Priority tier, Timestamp current_time) const;
+    bool ShouldHold(NestContext &nest, Order::Priority tier, OrderHandle anchor, Timestamp current_time) const;
+};
+
+// Every policy a scheduler can be configured with. ZipScheduler dispatches on it once per nest and tick.
+using AnyPolicy = std::variant<GreedyPolicy, NearestNeighborPolicy, LookaheadPolicy>;
+
+// The policy registered under name, or nullopt for an unknown name.
+std::optional<AnyPolicy> MakePolicy(std::string_view name);
+
+// Names of every policy in AnyPolicy, for usage messages.
+std::vector<std::string_view> PolicyNames();
+
+inline std::string_view PolicyName(const AnyPolicy &policy)
+{
+    return std::visit([](const auto &p) { return std::string_view{p.kName}; }, policy);
+}
+
+}  // namespace zipline
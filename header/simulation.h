@@ -0,0 +1,97 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "checkpoint.h"
+#include "delivery_stats.h"
+#include "flight.h"
+#include "order.h"
+#include "util.h"
+#include "zip_scheduler.h"
+
+namespace zipline
+{
+// Discrete-event driver for a ZipScheduler. Instead of stepping the clock one second at a time, the simulation
+// jumps straight to the next launch tick at which the scheduler could act: the tick after the next order arrives,
+// the tick after the next zip returns, or simply the next tick while launchable orders are waiting.
+class Simulation
+{
+   public:
+    using LaunchCallback = std::function<void(Timestamp, const std::vector<Flight> &)>;
+    // Produces orders in received-time order, returning nullopt once there are no more.
+    using OrderSource = std::function<std::optional<Order>()>;
+
+    Simulation(ZipScheduler &scheduler, Timestamp time_between_launches)
+        : scheduler_(scheduler), time_between_launches_(time_between_launches)
+    {
+    }
+
+    // Called with the flights returned by every LaunchFlights call the simulation makes.
+    void set_launch_callback(LaunchCallback callback)
+    {
+        launch_callback_ = std::move(callback);
+    }
+
+    // Every launched flight is also recorded into stats, which must outlive the simulation; nullptr turns it off.
+    void set_delivery_stats(DeliveryStats *stats)
+    {
+        delivery_stats_ = stats;
+    }
+
+    // Checkpoints the scheduler to path after every interval_ticks launch ticks; 0 turns checkpointing off. Each
+    // checkpoint is written beside path and renamed over it, so a crash never leaves a partial one behind.
+    void set_checkpointing(std::filesystem::path path, size_t interval_ticks)
+    {
+        checkpoint_path_ = std::move(path);
+        checkpoint_interval_ = interval_ticks;
+    }
+
+    // Replays orders (sorted by received time) through the scheduler until end_time (exclusive), which may be
+    // several days past the first order. Returns the number of launch ticks that were evaluated.
+    size_t Run(const std::vector<Order> &orders, Timestamp end_time);
+
+    // Same as above, pulling orders lazily from a reader instead of a preloaded vector.
+    size_t Run(OrderReader &orders, Timestamp end_time);
+
+    // Same as above for any order source; the source is only read one order ahead of the simulation clock.
+    size_t Run(const OrderSource &next_order, Timestamp end_time);
+
+    // Restores the scheduler from a checkpoint and carries on after its tick. next_order must produce the orders
+    // that followed the checkpoint's first CheckpointInfo::num_orders; replaying the same suffix launches the same
+    // flights as the original run did. Throws CheckpointError for an unreadable checkpoint.
+    size_t Resume(const std::filesystem::path &checkpoint, const OrderSource &next_order, Timestamp end_time);
+
+    // Same as above with the whole order log, skipping the orders the checkpoint already holds.
+    size_t Resume(const std::filesystem::path &checkpoint, OrderReader &orders, Timestamp end_time);
+
+   private:
+    ZipScheduler &scheduler_;
+    const Timestamp time_between_launches_;
+    LaunchCallback launch_callback_;
+    DeliveryStats *delivery_stats_{nullptr};
+    std::filesystem::path checkpoint_path_;
+    size_t checkpoint_interval_{0};
+    std::vector<Flight> flights_;  // launched at the latest tick, kept across ticks for its capacity
+
+    // Rounds a timestamp up to the next launch tick.
+    Timestamp AlignToLaunchGrid(Timestamp time) const;
+
+    // Next tick at which the scheduler could launch something after the tick at cur_time, or nullopt once every
+    // order has been delivered.
+    std::optional<Timestamp> NextLaunchTime(Timestamp cur_time, const std::optional<Order> &pending_order) const;
+
+    // Runs from cur_time with pending_order read ahead and num_orders already queued.
+    size_t RunFrom(const OrderSource &next_order, std::optional<Order> pending_order, Timestamp cur_time,
+                   uint64_t num_orders, Timestamp end_time);
+
+    CheckpointInfo LoadCheckpoint(const std::filesystem::path &checkpoint);
+    void SaveCheckpoint(const CheckpointInfo &info) const;
+    size_t ResumeFrom(const CheckpointInfo &info, const OrderSource &next_order, Timestamp end_time);
+};
+
+}  // namespace zipline
@@ -0,0 +1,148 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bounded_channel.h"
+#include "delivery_stats.h"
+#include "flight.h"
+#include "hospital.h"
+#include "order.h"
+#include "util.h"
+#include "zip_scheduler.h"
+
+namespace zipline
+{
+// Maps wall-clock time onto scheduler timestamps, running speedup times faster than real time once started.
+class StreamClock
+{
+   public:
+    using WallClock = std::chrono::steady_clock;
+
+    explicit StreamClock(double speedup) : speedup_(speedup)
+    {
+    }
+
+    // Pins time to the current wall-clock instant.
+    void Start(Timestamp time)
+    {
+        start_time_ = time;
+        wall_start_ = WallClock::now();
+    }
+
+    Timestamp Now() const;
+
+    // Wall-clock instant at which Now() reaches time.
+    WallClock::time_point WallTime(Timestamp time) const;
+
+   private:
+    const double speedup_;
+    Timestamp start_time_{0};
+    WallClock::time_point wall_start_;
+};
+
+struct StreamingOptions
+{
+    double speedup{1.0};                  // simulated seconds per wall-clock second
+    size_t queue_capacity{1024};          // orders buffered between the feed reader and the planner
+    std::optional<Timestamp> start_time;  // defaults to the first order's received time
+};
+
+// Why the streaming driver planned a tick.
+enum class LaunchTrigger
+{
+    kEmergency,  // an emergency order arrived
+    kZipReturn,  // a zip came back to a nest with orders waiting
+    kGrid,       // the regular launch grid, which still paces held resupply orders
+    kCount
+};
+
+// Real-time driver for a ZipScheduler. A reader thread parses orders in orders.csv format from a stream (stdin or a
+// FIFO) and hands them to the planner through a bounded channel; the planner follows a StreamClock and plans as
+// soon as an emergency arrives or a zip returns, as well as on the regular launch grid, so an emergency does not
+// sit out the rest of a launch interval.
+class StreamingDriver
+{
+   public:
+    using LaunchCallback = std::function<void(Timestamp, const std::vector<Flight> &)>;
+
+    StreamingDriver(ZipScheduler &scheduler, const HospitalTable &hospitals, Timestamp time_between_launches,
+                    const StreamingOptions &options = {});
+
+    // Called with the flights returned by every LaunchFlights call the driver makes.
+    void set_launch_callback(LaunchCallback callback)
+    {
+        launch_callback_ = std::move(callback);
+    }
+
+    // Every launched flight is also recorded into stats, which must outlive the driver; nullptr turns it off.
+    void set_delivery_stats(DeliveryStats *stats)
+    {
+        delivery_stats_ = stats;
+    }
+
+    // Plans orders read from input, named source in error messages, until the input ends and every order has been
+    // launched. Malformed lines are reported to stderr and skipped rather than stopping the stream. Returns the
+    // number of LaunchFlights calls made.
+    size_t Run(std::istream &input, const std::string &source);
+
+    // Number of LaunchFlights calls made for trigger.
+    size_t num_launches(LaunchTrigger trigger) const
+    {
+        return num_launches_[static_cast<size_t>(trigger)];
+    }
+
+    size_t num_orders() const
+    {
+        return num_orders_;
+    }
+
+    size_t num_rejected_lines() const
+    {
+        return num_rejected_lines_;
+    }
+
+    // Most orders that were ever waiting in the channel between the reader and the planner.
+    size_t peak_queue_depth() const
+    {
+        return channel_.peak_size();
+    }
+
+   private:
+    ZipScheduler &scheduler_;
+    const HospitalTable &hospitals_;
+    const Timestamp time_between_launches_;
+    const StreamingOptions options_;
+    StreamClock clock_;
+    BoundedChannel<Order> channel_;
+    LaunchCallback launch_callback_;
+    DeliveryStats *delivery_stats_{nullptr};
+
+    // Orders stamped ahead of the clock, held until it catches up. They count against the channel's capacity.
+    std::deque<Order> early_orders_;
+    std::vector<Flight> flights_;  // launched at the latest tick, kept across ticks for its capacity
+    std::optional<Timestamp> last_launch_time_;
+    size_t num_launches_[static_cast<size_t>(LaunchTrigger::kCount)]{};
+    size_t num_orders_{0};
+    std::atomic<size_t> num_rejected_lines_{0};
+
+    void ReadOrders(std::istream &input, const std::string &source);
+    std::optional<Order> ParseOrder(std::string_view line, const std::string &source, size_t line_number,
+                                    Timestamp last_timestamp) const;
+    Timestamp AlignToLaunchGrid(Timestamp time) const;
+    bool QueueDueOrders(Timestamp now);
+    bool ZipReturned(Timestamp now) const;
+    void Launch(Timestamp now, LaunchTrigger trigger);
+};
+
+}  // namespace zipline
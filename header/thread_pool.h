@@ -0,0 +1,54 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace zipline
+{
+// Fixed set of worker threads for fork-join loops. The calling thread takes part in every loop, so a pool with zero
+// workers simply runs the loop inline.
+class ThreadPool
+{
+   public:
+    explicit ThreadPool(size_t num_workers);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t num_workers() const
+    {
+        return workers_.size();
+    }
+
+    // Runs task(i) for every i in [0, count) and returns once all of them have finished. Tasks may run in any order
+    // and on any thread, so they must only write to state owned by their own index. Loops started from different
+    // threads take turns.
+    void ParallelFor(size_t count, const std::function<void(size_t)> &task);
+
+   private:
+    std::vector<std::thread> workers_;
+    std::mutex loop_mutex_;  // held by the thread whose loop is running
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+
+    const std::function<void(size_t)> *task_{nullptr};
+    size_t count_{0};
+    std::atomic<size_t> next_index_{0};
+    size_t active_workers_{0};
+    uint64_t generation_{0};
+    bool stopping_{false};
+
+    void WorkerLoop();
+    void RunTasks(const std::function<void(size_t)> &task, size_t count);
+};
+
+}  // namespace zipline
@@ -2,16 +2,18 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
-#include <string>
-#include <vector>
+#include <string_view>
 #include <cmath>
 
 namespace zipline
 {
 using Timestamp = int32_t;
 
-std::vector<std::string> ParseInputLine(const std::string &line);
+// Splits a comma-separated line into whitespace-trimmed views into the line. Fills at most max_fields entries of
+// fields and returns the total number of fields in the line.
+size_t SplitInputLine(std::string_view line, std::string_view *fields, size_t max_fields);
 
 // Helper utility function
 inline float GetDistanceBetweenPoints(const int p1_x, const int p1_y, const int p2_x, const int p2_y)
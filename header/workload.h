@@ -0,0 +1,60 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+
+#include "hospital.h"
+#include "order.h"
+#include "util.h"
+
+namespace zipline
+{
+enum class ArrivalPattern : uint8_t
+{
+    kPoisson,  // constant-rate Poisson arrivals
+    kBursty,   // Poisson arrivals whose rate switches between a calm and a burst level
+};
+
+// Shape of a synthetic service area and its order stream.
+struct WorkloadConfig
+{
+    size_t num_hospitals{50};
+    int radius{60 * 1000};  // (meters) hospitals are spread uniformly over a disk around the nest
+    double orders_per_hour{30.0};
+    double emergency_fraction{0.3};
+    ArrivalPattern arrivals{ArrivalPattern::kPoisson};
+    double burst_rate_factor{8.0};  // arrival rate during a burst relative to the calm rate
+    double burst_fraction{0.1};     // long-run fraction of time spent in a burst
+    Timestamp mean_burst_length{20 * 60};
+    Timestamp start_time{0};
+    uint64_t seed{1};
+};
+
+// Places config.num_hospitals hospitals named "Hospital <n>" around a single nest at (0, 0) and builds the leg tables.
+HospitalTable GenerateHospitals(const WorkloadConfig &config, int zip_speed);
+
+// Endless, reproducible stream of orders in received-time order. Orders are produced one at a time so arbitrarily
+// long workloads never have to be held in memory. The average arrival rate is config.orders_per_hour for both
+// arrival patterns.
+class OrderGenerator
+{
+   public:
+    OrderGenerator(const WorkloadConfig &config, const HospitalTable &hospitals);
+
+    Order Next();
+
+   private:
+    const WorkloadConfig config_;
+    const HospitalTable &hospitals_;
+    std::mt19937_64 rng_;
+    double current_time_;
+    double calm_rate_;  // (orders per second)
+    bool in_burst_{false};
+    double state_end_time_;
+
+    double NextStateLength();
+};
+
+}  // namespace zipline
@@ -1,54 +1,217 @@
 // Copyright 2021 Zipline International Inc. All rights reserved.
 #pragma once
 
+#include <atomic>
 #include <iostream>
 #include <memory>
-#include <unordered_set>
+#include <mutex>
+#include <optional>
 #include <vector>
 
 #include <functional>
+#include "arrival_rates.h"
+#include "batch_planner.h"
+#include "checkpoint.h"
+#include "event_log.h"
+#include "fleet.h"
 #include "flight.h"
+#include "hospital.h"
+#include "mpsc_ring.h"
 #include "order.h"
+#include "order_index.h"
+#include "order_queue.h"
+#include "profiler.h"
+#include "route_solver.h"
+#include "scheduler_config.h"
+#include "scheduling_policy.h"
+#include "thread_pool.h"
 #include "util.h"
 
-namespace
-{
-constexpr auto kMinResupplyOrders = 5;
-constexpr auto kMaxResupplyWaitTime = 15 * 60;  // 15 min in seconds
-constexpr auto kMaxRange = 160 * 1000;          // (meters) 160 km
-constexpr auto kMaxPackages = 3;
-constexpr auto kZipSpeed = 30;                     // (meters per second)
-constexpr auto kRangeReducedRange = 45 * 60 * 30;  // 45 min * 60 s/min * 30 m/s
-constexpr auto kNumZipsReducedRange = 2;           // 2 drones guaranteed to return within 45 min in resupply time
-}  // namespace
-
 namespace zipline
 {
 
 class ZipScheduler
 {
    public:
+    // Gives every nest config.num_zips zips. Throws std::invalid_argument for an unusable config.
+    explicit ZipScheduler(const HospitalTable &hospitals, const SchedulerConfig &config = {});
+
+    ZipScheduler(const ZipScheduler &) = delete;
+    ZipScheduler &operator=(const ZipScheduler &) = delete;
+
+    const SchedulerConfig &config() const
+    {
+        return config_;
+    }
+
+    // Gives every nest num_zips zips.
     void InitializeZips(const int num_zips);
 
-    // Add an order to the queue to potentially launch at the next time LaunchFlights is called.
-    void QueueOrder(const Order &order);
+    // Gives each nest its own number of zips, indexed like the nests in the HospitalTable.
+    void InitializeZips(const std::vector<int> &zips_per_nest);
+
+    // Plans with the given policy instead of the greedy one. Call before the first tick.
+    void set_policy(const AnyPolicy &policy)
+    {
+        policy_ = policy;
+    }
+
+    const AnyPolicy &policy() const
+    {
+        return policy_;
+    }
+
+    // Scheduler events are reported to event_log, which must outlive the scheduler; nullptr turns logging off. Takes
+    // the state lock, so the log can be swapped or detached while another thread cancels or amends an order.
+    void set_event_log(EventLog *event_log)
+    {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        event_log_ = event_log;
+    }
 
-    // Returns an ordered list of flights to launch.
+    // Tick phases and planning counters are timed into profiler, which must outlive the scheduler; nullptr turns
+    // profiling off.
+    void set_profiler(Profiler *profiler)
+    {
+        profiler_ = profiler;
+    }
+
+    // Add an order to the queue to potentially launch at the next time LaunchFlights is called, and return the id
+    // it can later be cancelled or amended by. Safe to call from any number of threads, including while
+    // LaunchFlights runs; it never waits for planning.
+    OrderId QueueOrder(const Order &order);
+
+    // Takes a pending order out of its queue. Returns false if the order has already launched, was cancelled or was
+    // never queued. Safe to call from any thread between or during ticks; it waits for a running tick to finish.
+    bool CancelOrder(OrderId id);
+
+    // Moves a pending order to another priority tier, for instance to upgrade resupply to an emergency. Its deadline
+    // becomes the new tier's, counted from its received time. Returns false like CancelOrder; throws
+    // std::invalid_argument for kUnknown.
+    bool ChangePriority(OrderId id, Order::Priority priority);
+
+    // Gives a pending order a new deadline within its tier. Returns false like CancelOrder.
+    bool ChangeDeadline(OrderId id, Timestamp deadline);
+
+    // Returns an ordered list of flights to launch. Only one thread may launch flights.
     std::vector<Flight> LaunchFlights(Timestamp current_time);
 
+    // Same as above, but replaces the contents of flights, so a caller that keeps the vector across ticks plans
+    // without touching the heap allocator once the backlog and flight counts have reached their high-water marks.
+    void LaunchFlights(Timestamp current_time, std::vector<Flight> &flights);
+
+    // Writes every nest's fleet and pending orders (including any not yet drained from the intake) tagged with info.
+    // Called from the launching thread between ticks.
+    void SaveCheckpoint(std::ostream &stream, const CheckpointInfo &info);
+
+    // Replaces every nest's fleet and pending orders with a checkpoint's and returns the info it was saved with.
+    // Throws CheckpointError if the checkpoint is malformed or was taken with other hospitals or nests. Called from
+    // the launching thread before the first tick of the resumed run.
+    CheckpointInfo LoadCheckpoint(std::istream &stream);
+
+    // True if any orders of any priority are still waiting to be launched. Called from the launching thread.
+    bool HasPendingOrders() const;
+
+    // Earliest time at which a zip is (or was) back at a nest that has orders waiting. Called from the launching
+    // thread.
+    Timestamp NextZipReturnTime() const;
+
+    // Earliest time at which a zip is (or was) back at the nest order would be queued at if it were queued now.
+    // Called from the launching thread.
+    Timestamp NextZipReturnTime(const Order &order) const;
+
    private:
-    std::vector<Timestamp> zip_return_times_;
-    std::vector<std::shared_ptr<Order>> emergency_orders_;
-    std::vector<std::shared_ptr<Order>> resupply_orders_;
-
-    std::vector<int> GetFreeZips(const Timestamp curr_time);
-    std::shared_ptr<Order> GetNextOrderByDist(int &curr_x, int &curr_y, int &curr_dist, int &return_dist,
-                                              const int max_range);
-    std::shared_ptr<Order> GetNextOrderInQueue(int &curr_x, int &curr_y, int &curr_dist, int &return_dist,
-                                               const int max_range, std::vector<std::shared_ptr<Order>> &orders);
-    void ScheduleFlights(const int zip_idx, std::vector<Flight> &flights, const int max_range, const int curr_time);
-    std::shared_ptr<Order> GetFirstOrder(int &curr_x, int &curr_y, int &curr_dist, int &return_dist,
-                        std::vector<std::shared_ptr<Order>> &orders);
+    static constexpr size_t kMinOrderIndexPurgeSize = 1024;
+
+    // An order handed over by QueueOrder, still waiting to be drained into a nest.
+    struct IntakeOrder
+    {
+        Order order;
+        OrderId id;
+    };
+
+    // Everything one nest plans with. Nests never touch each other's state, so they can be planned in parallel.
+    struct NestState
+    {
+        NestState(size_t nest_idx, const HospitalTable &hospitals, const SchedulerConfig &config)
+            : nest_idx(nest_idx),
+              node(hospitals.nest_id(nest_idx)),
+              routes(hospitals),
+              arrival_rates(hospitals.size(), config.lookahead.rate_time_constant)
+        {
+            queues.reserve(Order::kNumPriorities);
+            for (const auto &tier : config.tiers) queues.emplace_back(hospitals.size(), tier.time_to_deadline);
+        }
+
+        OrderQueue &queue(Order::Priority priority)
+        {
+            return queues[static_cast<size_t>(priority)];
+        }
+
+        const OrderQueue &queue(Order::Priority priority) const
+        {
+            return queues[static_cast<size_t>(priority)];
+        }
+
+        size_t pending_orders() const
+        {
+            size_t num_orders = 0;
+            for (const auto &orders : queues) num_orders += orders.size();
+            return num_orders;
+        }
+
+        size_t nest_idx;
+        HospitalId node;
+        Fleet fleet;
+        std::vector<OrderQueue> queues;  // pending orders, indexed by Order::Priority
+        RouteSolver routes;
+        ArrivalRates arrival_rates;                    // of the orders assigned to this nest
+        std::vector<PlannedFlight> planned_flights;    // planned at the current tick, not yet launched
+        std::vector<Flight> flights;                   // launched at the current tick
+        std::vector<std::vector<Order>> stop_buffers;  // emptied stop lists of launched flights, kept for reuse
+        std::vector<LeftoverOrder> leftovers;          // pending orders offered to the batch planner
+        BatchPlanner::Scratch batch_scratch;
+        size_t num_free_zips{0};
+    };
+
+    const HospitalTable &hospitals_;
+    const SchedulerConfig config_;
+    AnyPolicy policy_;
+    std::vector<NestState> nests_;
+    std::unique_ptr<ThreadPool> thread_pool_;  // only used with several nests
+    std::unique_ptr<BatchPlanner> batch_planner_;
+    std::unique_ptr<ThreadPool> batch_thread_pool_;
+    EventLog *event_log_{nullptr};
+    Profiler *profiler_{nullptr};
+
+    // Orders handed over by QueueOrder, moved into the nests' queues at the start of every tick. Producers only
+    // spill into the locked overflow list when the ring is full, and keep doing so until the next drain so each
+    // producer's orders stay in sequence.
+    MpscRing<IntakeOrder> intake_;
+    std::atomic<size_t> num_intake_orders_{0};
+    std::atomic<bool> intake_overflowing_{false};
+    std::mutex overflow_mutex_;
+    std::vector<IntakeOrder> overflow_orders_;
+    std::atomic<OrderId> next_order_id_{0};
+
+    // Where every drained order was queued, by id, guarded by state_mutex_. Orders taken by a flight are not erased
+    // from the index on the launch path; their entries go stale, are told apart by OrderQueue::Holds and are purged
+    // once they outnumber the live ones.
+    OrderIndex order_index_;
+    size_t order_index_purge_size_{kMinOrderIndexPurgeSize};
+
+    // Guards nests_ and the order index against order cancellations and amendments from other threads.
+    mutable std::mutex state_mutex_;
+
+    size_t DrainIntake();
+    void AddToNest(const IntakeOrder &intake_order);
+    OrderQueue *FindPendingOrder(OrderId id, OrderLocation *&location);
+    void PurgeOrderIndex();
+    void RebuildOrderIndex();
+    size_t AssignNest(const Order &order) const;
+    void PlanNest(NestState &nest, Timestamp current_time) const;
+    template <typename Policy>
+    void PlanNestWith(const Policy &policy, NestState &nest, Timestamp current_time) const;
 };
 
 }  // namespace zipline
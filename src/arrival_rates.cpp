@@ -0,0 +1,49 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "arrival_rates.h"
+
+#include <cmath>
+
+namespace zipline
+{
+// Each order adds 1 / time_constant, so a steady stream of r orders per second settles at a rate of r.
+void ArrivalRates::Record(const HospitalId hospital, const Timestamp time)
+{
+    Estimate &estimate = estimates_[hospital];
+    if (time > estimate.time)
+    {
+        estimate.rate *= std::exp(-static_cast<double>(time - estimate.time) / time_constant_);
+        estimate.time = time;
+    }
+    estimate.rate += 1.0 / time_constant_;
+}
+
+double ArrivalRates::Rate(const HospitalId hospital, const Timestamp time) const
+{
+    const Estimate &estimate = estimates_[hospital];
+    if (time <= estimate.time) return estimate.rate;
+    return estimate.rate * std::exp(-static_cast<double>(time - estimate.time) / time_constant_);
+}
+
+void ArrivalRates::Save(CheckpointWriter &writer) const
+{
+    writer.Write(static_cast<uint32_t>(estimates_.size()));
+    for (const auto &estimate : estimates_)
+    {
+        writer.Write(estimate.rate);
+        writer.Write(estimate.time);
+    }
+}
+
+void ArrivalRates::Load(CheckpointReader &reader)
+{
+    reader.Expect(reader.Read<uint32_t>() == estimates_.size(), "arrival rates for a different set of hospitals");
+    for (auto &estimate : estimates_)
+    {
+        estimate.rate = reader.Read<double>();
+        estimate.time = reader.Read<Timestamp>();
+        reader.Expect(estimate.rate >= 0.0, "negative arrival rate");
+    }
+}
+
+}  // namespace zipline
@@ -0,0 +1,278 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "batch_planner.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+
+#include "flight.h"
+
+namespace zipline
+{
+namespace
+{
+constexpr double kMinImprovement = 1e-6;
+constexpr double kInfeasible = std::numeric_limits<double>::infinity();
+
+// Stops of a candidate flight, built on the stack while moves are evaluated. A move adds at most one stop.
+struct CandidateStops
+{
+    std::array<Order, kMaxFlightStops + 1> orders;
+    size_t size{0};
+
+    std::span<Order> span()
+    {
+        return {orders.data(), size};
+    }
+
+    // Fills in a flight's stops without the one at index skip (-1 for none), followed by add if given.
+    void Assign(const std::vector<Order> &stops, const int skip, const Order *add)
+    {
+        size = 0;
+        for (size_t i = 0; i < stops.size(); ++i)
+        {
+            if (static_cast<int>(i) != skip) orders[size++] = stops[i];
+        }
+        if (add) orders[size++] = *add;
+    }
+};
+
+// Builds the stop lists of flights a and b after moving stop_a to b and stop_b to a (-1 moves nothing).
+void ExchangeStops(const PlannedFlight &flight_a, const PlannedFlight &flight_b, const int stop_a, const int stop_b,
+                   CandidateStops &stops_a, CandidateStops &stops_b)
+{
+    stops_a.Assign(flight_a.stops, stop_a, stop_b >= 0 ? &flight_b.stops[stop_b] : nullptr);
+    stops_b.Assign(flight_b.stops, stop_b, stop_a >= 0 ? &flight_a.stops[stop_a] : nullptr);
+}
+}  // namespace
+
+/*
+    Description: Scores a flight as the priority-weighted sum of its stops' time-to-delivery plus a small charge for
+                 the zip's time away from the nest, flying the stops in their best order.
+    Arguments:
+        - routes: solver used to order the stops
+        - nest: node the flight starts and ends at
+        - launch_time: when the flight takes off
+        - stops: orders on the flight; rewritten into visiting order when reorder is set
+        - max_range: range of the zip flying it
+        - reorder: whether to rewrite stops into the solved order
+    Returns: Cost in weighted seconds, or infinity if the flight is empty or out of range.
+*/
+double BatchPlanner::FlightCost(const RouteSolver &routes, const HospitalId nest, const Timestamp launch_time,
+                                const std::span<Order> stops, const int max_range, const bool reorder) const
+{
+    if (stops.empty() || stops.size() > max_packages_ || stops.size() > kMaxRouteStops) return kInfeasible;
+
+    const Route route = routes.SolveUncached(nest, stops);
+    if (route.distance >= max_range) return kInfeasible;
+
+    double cost = 0.0;
+    int dist = 0;
+    HospitalId prev = nest;
+    for (size_t i = 0; i < stops.size(); ++i)
+    {
+        const Order &order = stops[route.stop_order[i]];
+        dist += hospitals_.Distance(prev, order.hospital_id());
+        prev = order.hospital_id();
+        const double delivery_time = launch_time + static_cast<double>(dist) / zip_speed_ - order.received_time();
+        cost += Weight(order) * delivery_time;
+    }
+    cost += config_.return_time_weight * route.distance / zip_speed_;
+
+    if (reorder)
+    {
+        std::array<Order, kMaxRouteStops> ordered;
+        std::copy(stops.begin(), stops.end(), ordered.begin());
+        for (size_t i = 0; i < stops.size(); ++i) stops[i] = ordered[route.stop_order[i]];
+    }
+    return cost;
+}
+
+// Charges a pending order that stays behind as if it flew out on its own on the next zip available, but not before
+// its deadline, when its tier would launch it without waiting for a batch.
+double BatchPlanner::LeftBehindCost(const HospitalId nest, const Timestamp next_zip_time,
+                                    const LeftoverOrder &leftover) const
+{
+    const Order &order = leftover.order;
+    const double flight_time = static_cast<double>(hospitals_.Distance(nest, order.hospital_id())) / zip_speed_;
+    const Timestamp launch_time = std::max(next_zip_time, leftover.deadline);
+    return Weight(order) * (launch_time + flight_time - order.received_time());
+}
+
+// Length of the loop from the nest through stops in the given order and back.
+int BatchPlanner::LoopDistance(const HospitalId nest, const std::span<const Order> stops) const
+{
+    int dist = 0;
+    HospitalId prev = nest;
+    for (const auto &order : stops)
+    {
+        dist += hospitals_.Distance(prev, order.hospital_id());
+        prev = order.hospital_id();
+    }
+    return dist + hospitals_.Distance(prev, nest);
+}
+
+// Finds the best relocation or swap of one stop between flights a and b.
+BatchPlanner::Move BatchPlanner::BestMoveBetween(const RouteSolver &routes, const HospitalId nest,
+                                                 const Timestamp launch_time,
+                                                 const std::vector<PlannedFlight> &flights,
+                                                 const std::vector<double> &costs, const size_t a,
+                                                 const size_t b) const
+{
+    Move best{0.0, a, b, -1, -1, -1};
+    const auto &flight_a = flights[a];
+    const auto &flight_b = flights[b];
+    const double base_cost = costs[a] + costs[b];
+
+    CandidateStops stops_a;
+    CandidateStops stops_b;
+    auto evaluate = [&](int stop_a, int stop_b) {
+        ExchangeStops(flight_a, flight_b, stop_a, stop_b, stops_a, stops_b);
+
+        const double delta = FlightCost(routes, nest, launch_time, stops_a.span(), flight_a.max_range, false) +
+                             FlightCost(routes, nest, launch_time, stops_b.span(), flight_b.max_range, false) -
+                             base_cost;
+        if (delta < best.delta)
+        {
+            best = Move{delta, a, b, stop_a, stop_b, -1};
+        }
+    };
+
+    const int num_a = static_cast<int>(flight_a.stops.size());
+    const int num_b = static_cast<int>(flight_b.stops.size());
+    for (int i = 0; i < num_a; ++i) evaluate(i, -1);
+    for (int j = 0; j < num_b; ++j) evaluate(-1, j);
+    for (int i = 0; i < num_a; ++i)
+    {
+        for (int j = 0; j < num_b; ++j) evaluate(i, j);
+    }
+    return best;
+}
+
+// Finds the best leftover order to add to flight b.
+BatchPlanner::Move BatchPlanner::BestInsertInto(const RouteSolver &routes, const HospitalId nest,
+                                                const Timestamp launch_time,
+                                                const std::vector<PlannedFlight> &flights,
+                                                const std::vector<double> &costs,
+                                                const std::vector<LeftoverOrder> &leftovers,
+                                                const Timestamp next_zip_time, const size_t b) const
+{
+    Move best{0.0, b, b, -1, -1, -1};
+    const auto &flight = flights[b];
+    if (flight.stops.size() >= max_packages_) return best;
+
+    CandidateStops stops;
+    for (size_t k = 0; k < leftovers.size(); ++k)
+    {
+        if (leftovers[k].taken) continue;
+        stops.Assign(flight.stops, -1, &leftovers[k].order);
+        const double delta = FlightCost(routes, nest, launch_time, stops.span(), flight.max_range, false) - costs[b] -
+                             LeftBehindCost(nest, next_zip_time, leftovers[k]);
+        if (delta < best.delta)
+        {
+            best = Move{delta, b, b, -1, -1, static_cast<int>(k)};
+        }
+    }
+    return best;
+}
+
+/*
+    Description: Local search over every pair of flights planned at this tick and over the leftover pending orders.
+                 Each round evaluates all candidate moves (in parallel when a thread pool is set) and applies the
+                 single best improving one, until nothing improves or max_moves moves have been applied. Ties go to
+                 the lowest flight pair, then to the lowest flight and leftover, so the result never depends on
+                 thread timing and a checkpointed run replays the same flights.
+    Arguments:
+        - routes: the nest's route solver
+        - nest: node the flights start and end at
+        - launch_time: when the flights take off
+        - flights: greedy plan to improve; rewritten in place
+        - leftovers: pending orders the plan left behind; the ones a flight takes are marked taken
+        - next_zip_time: when the nest could next launch a zip for a leftover order that stays behind
+        - scratch: the nest's buffers, reused across ticks
+    Returns: Number of moves applied.
+*/
+size_t BatchPlanner::Improve(const RouteSolver &routes, const HospitalId nest, const Timestamp launch_time,
+                             std::vector<PlannedFlight> &flights, std::vector<LeftoverOrder> &leftovers,
+                             const Timestamp next_zip_time, Scratch &scratch) const
+{
+    if (flights.empty()) return 0;
+
+    // the policy always flies a flight's anchor, even past a reduced range; such a flight may keep its length
+    for (auto &flight : flights) flight.max_range = std::max(flight.max_range, flight.distance + 1);
+
+    std::vector<double> &costs = scratch.costs;
+    costs.resize(flights.size());
+    for (size_t i = 0; i < flights.size(); ++i)
+    {
+        costs[i] = FlightCost(routes, nest, launch_time, flights[i].stops, flights[i].max_range, false);
+    }
+
+    std::vector<std::pair<size_t, size_t>> &pairs = scratch.pairs;
+    pairs.clear();
+    for (size_t a = 0; a < flights.size(); ++a)
+    {
+        for (size_t b = a + 1; b < flights.size(); ++b) pairs.emplace_back(a, b);
+    }
+    // every pair of flights, then every flight a leftover could join
+    std::vector<Move> &moves = scratch.moves;
+    moves.resize(pairs.size() + (leftovers.empty() ? 0 : flights.size()));
+
+    size_t num_moves = 0;
+    while (num_moves < config_.max_moves)
+    {
+        auto evaluate = [&](size_t i) {
+            if (i < pairs.size())
+            {
+                moves[i] = BestMoveBetween(routes, nest, launch_time, flights, costs, pairs[i].first, pairs[i].second);
+            }
+            else
+            {
+                moves[i] = BestInsertInto(routes, nest, launch_time, flights, costs, leftovers, next_zip_time,
+                                          i - pairs.size());
+            }
+        };
+        if (thread_pool_)
+        {
+            thread_pool_->ParallelFor(moves.size(), evaluate);
+        }
+        else
+        {
+            for (size_t i = 0; i < moves.size(); ++i) evaluate(i);
+        }
+
+        const Move *best = nullptr;
+        for (const auto &move : moves)
+        {
+            if (move.delta < -kMinImprovement && (!best || move.delta < best->delta)) best = &move;
+        }
+        if (!best) break;
+
+        const Move move = *best;
+        auto &flight_a = flights[move.flight_a];
+        auto &flight_b = flights[move.flight_b];
+        if (move.leftover >= 0)
+        {
+            flight_b.stops.push_back(leftovers[move.leftover].order);
+            leftovers[move.leftover].taken = true;
+        }
+        else
+        {
+            CandidateStops stops_a;
+            CandidateStops stops_b;
+            ExchangeStops(flight_a, flight_b, move.stop_a, move.stop_b, stops_a, stops_b);
+            flight_a.stops.assign(stops_a.orders.begin(), stops_a.orders.begin() + stops_a.size);
+            flight_b.stops.assign(stops_b.orders.begin(), stops_b.orders.begin() + stops_b.size);
+            costs[move.flight_a] = FlightCost(routes, nest, launch_time, flight_a.stops, flight_a.max_range, true);
+            flight_a.distance = LoopDistance(nest, flight_a.stops);
+        }
+        costs[move.flight_b] = FlightCost(routes, nest, launch_time, flight_b.stops, flight_b.max_range, true);
+        flight_b.distance = LoopDistance(nest, flight_b.stops);
+        num_moves++;
+    }
+    return num_moves;
+}
+
+}  // namespace zipline
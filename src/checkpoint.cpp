@@ -0,0 +1,34 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "checkpoint.h"
+
+#include <cstring>
+
+namespace
+{
+constexpr char kMagic[7] = {'Z', 'I', 'P', 'C', 'K', 'P', 'T'};
+}  // namespace
+
+namespace zipline
+{
+CheckpointWriter::CheckpointWriter(std::ostream &stream) : stream_(stream)
+{
+    stream_.write(kMagic, sizeof(kMagic));
+    Write(kVersion);
+}
+
+CheckpointReader::CheckpointReader(std::istream &stream) : stream_(stream)
+{
+    char magic[sizeof(kMagic)];
+    if (!stream_.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0)
+    {
+        throw CheckpointError("Not a scheduler checkpoint");
+    }
+    const auto version = Read<uint8_t>();
+    if (version != CheckpointWriter::kVersion)
+    {
+        throw CheckpointError("Unsupported checkpoint version " + std::to_string(version));
+    }
+}
+
+}  // namespace zipline
@@ -0,0 +1,101 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "csv_reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <system_error>
+
+#include "util.h"
+
+namespace zipline
+{
+ParseError::ParseError(const std::filesystem::path &filename, const size_t line, const std::string &message)
+    : std::runtime_error(filename.string() + ":" + std::to_string(line) + ": " + message), line_(line)
+{
+}
+
+MappedFile::MappedFile(const std::filesystem::path &filename)
+{
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "Could not open " + filename.string());
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+    {
+        const int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "Could not stat " + filename.string());
+    }
+
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ > 0)
+    {
+        void *data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "Could not map " + filename.string());
+        }
+        ::madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char *>(data);
+    }
+    ::close(fd);  // the mapping stays valid after the descriptor is closed
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_) ::munmap(const_cast<char *>(data_), size_);
+}
+
+bool CsvReader::NextRow()
+{
+    const std::string_view contents = file_.contents();
+    while (offset_ < contents.size())
+    {
+        size_t end = contents.find('\n', offset_);
+        if (end == std::string_view::npos) end = contents.size();
+        std::string_view line = contents.substr(offset_, end - offset_);
+        offset_ = end + 1;
+        line_++;
+
+        num_fields_ = SplitInputLine(line, fields_.data(), fields_.size());
+        if (num_fields_ > 1 || !fields_[0].empty()) return true;
+    }
+    return false;
+}
+
+void CsvReader::Fail(const std::string &message) const
+{
+    throw ParseError(filename_, line_, message);
+}
+
+void CsvReader::ExpectFields(const size_t num_fields, const char *row_kind) const
+{
+    if (num_fields_ != num_fields)
+    {
+        Fail(std::string("Got wrong number of ") + row_kind + " elements (expected " + std::to_string(num_fields) +
+             ")");
+    }
+}
+
+int CsvReader::ParseInt(const size_t idx, const char *field_name) const
+{
+    const std::string_view text = fields_[idx];
+    int value = 0;
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc{} || end != text.data() + text.size() || text.empty())
+    {
+        Fail(std::string("Invalid ") + field_name + " '" + std::string(text) + "'");
+    }
+    return value;
+}
+
+}  // namespace zipline
@@ -0,0 +1,59 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "delivery_stats.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace zipline
+{
+void DeliveryStats::Record(const Flight &flight)
+{
+    if (flight.num_stops() == 0) return;
+
+    const auto orders = flight.orders();
+    const auto etas = flight.etas();
+    for (size_t i = 0; i < orders.size(); ++i)
+    {
+        const Timestamp delivery_time = std::max<Timestamp>(0, etas[i] - orders[i].received_time());
+        delivery_times_[static_cast<size_t>(orders[i].priority())].Record(static_cast<uint64_t>(delivery_time));
+    }
+
+    if (num_flights_ == 0) first_launch_time_ = flight.launch_time();
+    first_launch_time_ = std::min(first_launch_time_, flight.launch_time());
+    last_return_time_ = std::max(last_return_time_, flight.return_time());
+
+    num_flights_++;
+    num_packages_ += orders.size();
+    total_distance_ += flight.total_distance();
+    busy_time_ += flight.return_time() - flight.launch_time();
+}
+
+double DeliveryStats::zip_utilization() const
+{
+    const double span = static_cast<double>(last_return_time_ - first_launch_time_) * num_zips_;
+    return span > 0 ? static_cast<double>(busy_time_) / span : 0.0;
+}
+
+void DeliveryStats::Print(std::ostream &out) const
+{
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(1);
+    // every field is preceded by a space so columns stay apart when a value outgrows its width
+    out << std::left << std::setw(18) << "Delivery time (s)" << std::right << ' ' << std::setw(9) << "count" << ' '
+        << std::setw(10) << "mean" << ' ' << std::setw(8) << "p50" << ' ' << std::setw(8) << "p95" << ' '
+        << std::setw(8) << "max" << "\n";
+    for (const auto priority : Order::kPrioritiesByUrgency)
+    {
+        const auto &times = delivery_times(priority);
+        out << std::left << std::setw(18) << Order::PriorityToString(priority) << std::right << ' ' << std::setw(9)
+            << times.count() << ' ' << std::setw(10) << times.mean() << ' ' << std::setw(8) << times.Percentile(0.5)
+            << ' ' << std::setw(8) << times.Percentile(0.95) << ' ' << std::setw(8) << times.max() << "\n";
+    }
+    out << "Flights: " << num_flights_ << ", packages: " << num_packages_ << "\n";
+    out << "Distance per package: " << distance_per_package() / 1000 << " km\n";
+    out << "Zip utilization: " << zip_utilization() * 100 << "%\n";
+    out.flags(flags);
+}
+
+}  // namespace zipline
@@ -0,0 +1,190 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "event_log.h"
+
+#include <chrono>
+#include <iostream>
+
+namespace zipline
+{
+namespace
+{
+constexpr auto kIdleDrainInterval = std::chrono::milliseconds(1);
+
+const char *EventName(EventType type)
+{
+    switch (type)
+    {
+        case EventType::kOrderQueued:
+            return "order_queued";
+        case EventType::kTickStarted:
+            return "tick_started";
+        case EventType::kFlightLaunched:
+            return "flight_launched";
+        case EventType::kStopPlanned:
+            return "stop_planned";
+        case EventType::kTickSummary:
+            return "tick_summary";
+    }
+    return "unknown";
+}
+}  // namespace
+
+void TextEventSink::Write(const LogEvent &event)
+{
+    switch (event.type)
+    {
+        case EventType::kOrderQueued:
+        {
+            stream_ << "Queuing order:\n\t" << event.time << "\n\t" << hospitals_.at(event.hospital).name() << "\n\t"
+                    << Order::PriorityToString(event.priority) << "\n";
+            break;
+        }
+        case EventType::kTickStarted:
+        {
+            stream_ << "Asking for flights at " << event.time << "\n";
+            break;
+        }
+        case EventType::kFlightLaunched:
+        {
+            stream_ << "Flight " << event.values[0] << "\n";
+            break;
+        }
+        case EventType::kStopPlanned:
+        {
+            stream_ << "Executing order:\n\t" << event.time << "\n\t" << hospitals_.at(event.hospital).name() << "\n\t"
+                    << Order::PriorityToString(event.priority) << "\n\n";
+            break;
+        }
+        case EventType::kTickSummary:
+        {
+            stream_ << "Number of available zips: " << event.values[0] << "\n"
+                    << "Number of zips taking off: " << event.values[1] << "\n"
+                    << "Number of emergency orders remaining: " << event.values[2] << "\n"
+                    << "Number of resupply orders remaining: " << event.values[3] << "\n"
+                    << "-----------------------------------------------------------\n";
+            break;
+        }
+    }
+}
+
+void TextEventSink::Flush()
+{
+    stream_.flush();
+}
+
+void JsonLinesEventSink::Write(const LogEvent &event)
+{
+    stream_ << "{\"event\":\"" << EventName(event.type) << "\",\"time\":" << event.time;
+    switch (event.type)
+    {
+        case EventType::kOrderQueued:
+        case EventType::kStopPlanned:
+        {
+            stream_ << ",\"hospital\":\"" << hospitals_.at(event.hospital).name() << "\",\"priority\":\""
+                    << Order::PriorityToString(event.priority) << "\"";
+            if (event.type == EventType::kOrderQueued)
+            {
+                stream_ << ",\"nest\":" << event.values[0];
+            }
+            else
+            {
+                stream_ << ",\"flight\":" << event.values[0];
+            }
+            break;
+        }
+        case EventType::kTickStarted:
+        {
+            break;
+        }
+        case EventType::kFlightLaunched:
+        {
+            stream_ << ",\"flight\":" << event.values[0] << ",\"nest\":" << event.values[1]
+                    << ",\"zip\":" << event.values[2] << ",\"stops\":" << event.values[3];
+            break;
+        }
+        case EventType::kTickSummary:
+        {
+            stream_ << ",\"free_zips\":" << event.values[0] << ",\"flights\":" << event.values[1]
+                    << ",\"emergency_pending\":" << event.values[2] << ",\"resupply_pending\":" << event.values[3];
+            break;
+        }
+    }
+    stream_ << "}\n";
+}
+
+void JsonLinesEventSink::Flush()
+{
+    stream_.flush();
+}
+
+BinaryEventSink::BinaryEventSink(std::ostream &stream) : stream_(stream)
+{
+    const char header[8] = {'Z', 'I', 'P', 'E', 'V', 'T', static_cast<char>(kVersion),
+                            static_cast<char>(sizeof(LogEvent))};
+    stream_.write(header, sizeof(header));
+}
+
+void BinaryEventSink::Write(const LogEvent &event)
+{
+    stream_.write(reinterpret_cast<const char *>(&event), sizeof(event));
+}
+
+void BinaryEventSink::Flush()
+{
+    stream_.flush();
+}
+
+EventLog::EventLog(std::unique_ptr<EventSink> sink, const LogLevel level, const LogOverflow overflow,
+                   const size_t capacity)
+    : sink_(std::move(sink)), level_(level), overflow_(overflow), ring_(capacity)
+{
+    drain_thread_ = std::thread([this] { DrainLoop(); });
+}
+
+EventLog::~EventLog()
+{
+    stopping_.store(true, std::memory_order_release);
+    drain_thread_.join();
+    if (dropped() > 0)
+    {
+        std::cerr << "Event log dropped " << dropped() << " events while its buffer was full" << std::endl;
+    }
+}
+
+// The background thread keeps draining until the log is destroyed, which happens only once producers are done.
+void EventLog::PushWhenFree(const LogEvent &event)
+{
+    while (!ring_.TryPush(event)) std::this_thread::yield();
+}
+
+void EventLog::DrainLoop()
+{
+    LogEvent event;
+    bool unflushed = false;
+    while (true)
+    {
+        // read the flag before draining so nothing pushed before shutdown is missed
+        const bool stopping = stopping_.load(std::memory_order_acquire);
+        bool drained_any = false;
+        while (ring_.TryPop(event))
+        {
+            sink_->Write(event);
+            drained_any = true;
+        }
+        if (stopping) break;
+        if (drained_any)
+        {
+            unflushed = true;
+        }
+        else
+        {
+            if (unflushed) sink_->Flush();
+            unflushed = false;
+            std::this_thread::sleep_for(kIdleDrainInterval);
+        }
+    }
+    sink_->Flush();
+}
+
+}  // namespace zipline
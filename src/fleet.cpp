@@ -0,0 +1,128 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "fleet.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
+namespace zipline
+{
+void Fleet::Initialize(const int num_zips, const int num_reduced_range)
+{
+    const int first_reduced = std::max(0, num_zips - num_reduced_range);
+
+    return_times_.assign(num_zips, 0);
+    range_classes_.assign(num_zips, RangeClass::kFull);
+    busy_zips_.clear();
+    busy_zips_.reserve(num_zips);
+    for (auto &free_zips : free_zips_)
+    {
+        free_zips.clear();
+        free_zips.reserve(num_zips);
+    }
+
+    for (int i = 0; i < num_zips; ++i)
+    {
+        if (i >= first_reduced) range_classes_[i] = RangeClass::kReduced;
+        PushFree(i);
+    }
+}
+
+void Fleet::PushFree(const int zip_idx)
+{
+    auto &free_zips = free_zips_[static_cast<size_t>(range_classes_[zip_idx])];
+    free_zips.push_back(zip_idx);
+    std::push_heap(free_zips.begin(), free_zips.end(), std::greater<int>{});
+}
+
+void Fleet::ReleaseReturned(const Timestamp now)
+{
+    while (!busy_zips_.empty() && busy_zips_.front().first <= now)
+    {
+        std::pop_heap(busy_zips_.begin(), busy_zips_.end(), std::greater<BusyEntry>{});
+        PushFree(busy_zips_.back().second);
+        busy_zips_.pop_back();
+    }
+    last_release_time_ = now;
+}
+
+int Fleet::TakeLowestFree()
+{
+    assert(HasFree() && "No free zips");
+
+    std::vector<int> *lowest = nullptr;
+    for (auto &free_zips : free_zips_)
+    {
+        if (!free_zips.empty() && (!lowest || free_zips.front() < lowest->front())) lowest = &free_zips;
+    }
+
+    std::pop_heap(lowest->begin(), lowest->end(), std::greater<int>{});
+    const int zip_idx = lowest->back();
+    lowest->pop_back();
+    return zip_idx;
+}
+
+void Fleet::Launch(const int zip_idx, const Timestamp return_time)
+{
+    return_times_[zip_idx] = return_time;
+    busy_zips_.emplace_back(return_time, zip_idx);
+    std::push_heap(busy_zips_.begin(), busy_zips_.end(), std::greater<BusyEntry>{});
+}
+
+Timestamp Fleet::NextReturnTime() const
+{
+    assert(size() > 0 && "Fleet has not been initialized");
+    if (HasFree()) return last_release_time_;
+    return busy_zips_.front().first;
+}
+
+void Fleet::Save(CheckpointWriter &writer) const
+{
+    std::vector<uint8_t> flying(size(), 0);
+    for (const auto &[return_time, zip_idx] : busy_zips_) flying[zip_idx] = 1;
+
+    writer.Write(static_cast<uint32_t>(size()));
+    writer.Write(last_release_time_);
+    for (size_t i = 0; i < size(); ++i)
+    {
+        writer.Write(range_classes_[i]);
+        writer.Write(return_times_[i]);
+        writer.Write(flying[i]);
+    }
+}
+
+// The heaps are keyed on (return time, index) and index alone, so rebuilding them from the saved zips restores
+// exactly the order in which zips are handed out.
+void Fleet::Load(CheckpointReader &reader)
+{
+    const auto num_zips = reader.Read<uint32_t>();
+    return_times_.assign(num_zips, 0);
+    range_classes_.assign(num_zips, RangeClass::kFull);
+    busy_zips_.clear();
+    busy_zips_.reserve(num_zips);
+    for (auto &free_zips : free_zips_)
+    {
+        free_zips.clear();
+        free_zips.reserve(num_zips);
+    }
+
+    last_release_time_ = reader.Read<Timestamp>();
+    for (uint32_t i = 0; i < num_zips; ++i)
+    {
+        range_classes_[i] = reader.Read<RangeClass>();
+        reader.Expect(range_classes_[i] < RangeClass::kCount, "unknown range class");
+        const auto return_time = reader.Read<Timestamp>();
+        if (reader.Read<uint8_t>())
+        {
+            Launch(static_cast<int>(i), return_time);
+        }
+        else
+        {
+            return_times_[i] = return_time;
+            PushFree(static_cast<int>(i));
+        }
+    }
+}
+
+}  // namespace zipline
@@ -0,0 +1,42 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "flight.h"
+
+#include <cassert>
+
+namespace zipline
+{
+namespace
+{
+// Seconds to fly a distance, rounded up to a whole second.
+Timestamp FlightDuration(const int distance, const int zip_speed)
+{
+    return static_cast<Timestamp>((distance + zip_speed - 1) / zip_speed);
+}
+}  // namespace
+
+Flight::Flight(const Timestamp launch_time, const std::span<const Order> stops, const size_t nest_idx,
+               const int zip_idx, const HospitalTable &hospitals, const int zip_speed)
+    : launch_time_(launch_time),
+      zip_idx_(zip_idx),
+      nest_idx_(static_cast<uint16_t>(nest_idx)),
+      num_stops_(static_cast<uint8_t>(stops.size()))
+{
+    assert(stops.size() <= kMaxFlightStops && "Too many stops for one flight");
+
+    const HospitalId nest = hospitals.nest_id(nest_idx);
+    HospitalId curr_node = nest;
+    for (size_t i = 0; i < stops.size(); ++i)
+    {
+        orders_[i] = stops[i];
+        leg_distances_[i] = hospitals.Distance(curr_node, stops[i].hospital_id());
+        total_distance_ += leg_distances_[i];
+        etas_[i] = launch_time + FlightDuration(total_distance_, zip_speed);
+        curr_node = stops[i].hospital_id();
+    }
+    leg_distances_[stops.size()] = hospitals.Distance(curr_node, nest);
+    total_distance_ += leg_distances_[stops.size()];
+    return_time_ = launch_time + FlightDuration(total_distance_, zip_speed);
+}
+
+}  // namespace zipline
@@ -0,0 +1,67 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace zipline
+{
+// Values below kSubBucketCount get a bucket each. Larger values keep their top kSubBucketBits bits: the shift picks
+// the power of two and the remaining bits the linear sub-bucket within it.
+size_t Histogram::BucketIndex(const uint64_t value)
+{
+    if (value < kSubBucketCount) return static_cast<size_t>(value);
+    const int msb = 63 - std::countl_zero(value);
+    const int shift = msb - (kSubBucketBits - 1);
+    const uint64_t sub_bucket = value >> shift;  // in [kHalfSubBucketCount, kSubBucketCount)
+    return static_cast<size_t>(shift * kHalfSubBucketCount + sub_bucket);
+}
+
+uint64_t Histogram::BucketUpperBound(const size_t index)
+{
+    if (index < kSubBucketCount) return index;
+    const uint64_t shift = index / kHalfSubBucketCount - 1;
+    const uint64_t sub_bucket = index - shift * kHalfSubBucketCount;
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+void Histogram::Record(const uint64_t value)
+{
+    counts_[BucketIndex(value)]++;
+    count_++;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    sum_ += static_cast<double>(value);
+}
+
+void Histogram::Merge(const Histogram &other)
+{
+    for (size_t i = 0; i < kNumBuckets; ++i) counts_[i] += other.counts_[i];
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    sum_ += other.sum_;
+}
+
+void Histogram::Clear()
+{
+    *this = Histogram{};
+}
+
+uint64_t Histogram::Percentile(const double fraction) const
+{
+    if (count_ == 0) return 0;
+
+    const auto target = static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * count_));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i)
+    {
+        seen += counts_[i];
+        if (seen >= std::max<uint64_t>(target, 1)) return std::min(BucketUpperBound(i), max_);
+    }
+    return max_;
+}
+
+}  // namespace zipline
@@ -2,31 +2,101 @@
 
 #include "hospital.h"
 
+#include <algorithm>
 #include <cassert>
-#include <fstream>
+#include <limits>
 #include <vector>
-#include <iostream>
 
+#include "csv_reader.h"
 #include "util.h"
 
 namespace zipline
 {
-std::unordered_map<std::string, Hospital> Hospital::LoadHospitals(const std::filesystem::path &filename)
+HospitalTable Hospital::LoadHospitals(const std::filesystem::path &filename, const int zip_speed,
+                                      const std::filesystem::path &nests_filename)
 {
-    std::ifstream stream{filename};
+    HospitalTable hospitals;
 
-    std::unordered_map<std::string, Hospital> hospitals;
-
-    std::string line{};
-    while (std::getline(stream, line, '\n'))
+    CsvReader reader{filename};
+    while (reader.NextRow())
     {
-        auto tokens = ParseInputLine(line);
+        reader.ExpectFields(3, "hospital");
+        const std::string name{reader.field(0)};
+        if (hospitals.Find(name)) reader.Fail("Duplicate hospital '" + name + "'");
+        hospitals.Add(name, reader.ParseInt(1, "north"), reader.ParseInt(2, "east"));
+    }
 
-        assert(tokens.size() == 3 && "Got wrong number of hospital elements");
-        hospitals.insert({tokens[0], Hospital{tokens[0], atoi(tokens[1].c_str()), atoi(tokens[2].c_str())}});
+    if (!nests_filename.empty())
+    {
+        CsvReader nests_reader{nests_filename};
+        while (nests_reader.NextRow())
+        {
+            nests_reader.ExpectFields(3, "nest");
+            hospitals.AddNest(std::string{nests_reader.field(0)}, nests_reader.ParseInt(1, "north"),
+                              nests_reader.ParseInt(2, "east"));
+        }
     }
 
+    hospitals.BuildLegTables(zip_speed);
     return hospitals;
 }
 
+HospitalId HospitalTable::Add(const std::string &name, const int north, const int east)
+{
+    assert(hospitals_.size() < std::numeric_limits<HospitalId>::max() && "Too many hospitals for HospitalId");
+    const auto id = static_cast<HospitalId>(hospitals_.size());
+    hospitals_.emplace_back(id, name, north, east);
+    ids_.insert({name, id});
+    return id;
+}
+
+void HospitalTable::AddNest(const std::string &name, const int north, const int east)
+{
+    assert(hospitals_.size() + nests_.size() < std::numeric_limits<HospitalId>::max() && "Too many nodes");
+    nests_.emplace_back(static_cast<HospitalId>(nests_.size()), name, north, east);
+}
+
+void HospitalTable::BuildLegTables(const int zip_speed)
+{
+    if (nests_.empty()) AddNest("Nest", 0, 0);
+
+    // nest ids are only final once every hospital has been added
+    std::vector<Hospital> nests;
+    for (size_t i = 0; i < nests_.size(); ++i)
+    {
+        nests.emplace_back(nest_id(i), nests_[i].name(), nests_[i].north(), nests_[i].east());
+    }
+    nests_.swap(nests);
+
+    num_nodes_ = hospitals_.size() + nests_.size();  // hospitals followed by the nests
+    distances_.assign(num_nodes_ * num_nodes_, 0);
+    flight_times_.assign(num_nodes_ * num_nodes_, 0.0f);
+
+    auto node = [this](size_t id) -> const Hospital & {
+        return id < hospitals_.size() ? hospitals_[id] : nests_[id - hospitals_.size()];
+    };
+    auto east = [&node](size_t id) { return node(id).east(); };
+    auto north = [&node](size_t id) { return node(id).north(); };
+
+    for (size_t from = 0; from < num_nodes_; ++from)
+    {
+        for (size_t to = 0; to < num_nodes_; ++to)
+        {
+            const int dist = GetDistanceBetweenPoints(east(from), north(from), east(to), north(to));
+            distances_[from * num_nodes_ + to] = dist;
+            flight_times_[from * num_nodes_ + to] = static_cast<float>(dist) / zip_speed;
+        }
+    }
+
+    neighbors_.assign(num_nodes_, {});
+    for (size_t from = 0; from < num_nodes_; ++from)
+    {
+        auto &neighbors = neighbors_[from];
+        for (size_t to = 0; to < hospitals_.size(); ++to) neighbors.push_back(static_cast<HospitalId>(to));
+        std::stable_sort(neighbors.begin(), neighbors.end(), [this, from](HospitalId a, HospitalId b) {
+            return Distance(from, a) < Distance(from, b);
+        });
+    }
+}
+
 }  // namespace zipline
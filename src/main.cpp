@@ -1,59 +1,231 @@
 // Copyright 2021 Zipline International Inc. All rights reserved.
 
 #include <cassert>
+#include <chrono>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
 
+#include "checkpoint.h"
+#include "delivery_stats.h"
+#include "event_log.h"
 #include "hospital.h"
+#include "profiler.h"
 #include "order.h"
+#include "scheduling_policy.h"
+#include "simulation.h"
+#include "streaming.h"
 #include "zip_scheduler.h"
 
 namespace
 {
-// Moved kMaxRange, kMaxPackages, kZipSpeed to zip_scheduler.h
-// constexpr auto kMaxRange = 160 * 1000;  // (meters) 160 km
-// constexpr auto kMaxPackages = 3;
-// constexpr auto kZipSpeed = 30;         // (meters per second)
-constexpr auto kTimeBetweenLaunches = 60;  // (seconds)
-constexpr auto kSecondsPerDay = 24 * 60 * 60;
-constexpr auto kNumZips = 10;
+// Fleet and policy parameters are the SchedulerConfig defaults; see zip_sweep for what-if scenarios.
+constexpr size_t kDefaultBatchPlanningMoves = 32;                  // per nest per tick
+constexpr size_t kDefaultCheckpointInterval = 60;                  // launch ticks between checkpoints
+constexpr auto kDefaultTickBudget = std::chrono::milliseconds(5);  // ticks slower than this are profiled in detail
+
+// Builds the event log selected by --log=text|json|binary|off (text by default). With --log-drop a full log buffer
+// drops events instead of holding up the scheduler.
+std::unique_ptr<zipline::EventLog> MakeEventLog(std::string_view format, const zipline::LogOverflow overflow,
+                                                const zipline::HospitalTable &hospitals)
+{
+    std::unique_ptr<zipline::EventSink> sink;
+    if (format == "text")
+    {
+        sink = std::make_unique<zipline::TextEventSink>(std::cout, hospitals);
+    }
+    else if (format == "json")
+    {
+        sink = std::make_unique<zipline::JsonLinesEventSink>(std::cout, hospitals);
+    }
+    else if (format == "binary")
+    {
+        sink = std::make_unique<zipline::BinaryEventSink>(std::cout);
+    }
+    else
+    {
+        return nullptr;
+    }
+    return std::make_unique<zipline::EventLog>(std::move(sink), zipline::LogLevel::kDebug, overflow);
+}
 }  // namespace
 
 using zipline::Hospital;
 using zipline::Order;
 using zipline::Timestamp;
 
-int main()
+int main(int argc, char **argv)
+try
 {
-    auto hospitals = Hospital::LoadHospitals("../inputs/hospitals.csv");
-    for (const auto &[hospital_name, hospital] : hospitals)
+    std::string_view log_format = "text";
+    zipline::LogOverflow log_overflow = zipline::LogOverflow::kBlock;
+    bool print_kpis = false;
+    size_t batch_planning_moves = 0;  // --batch-planning[=<moves>] improves each tick's flights together
+    std::filesystem::path checkpoint_file;  // --checkpoint=<file> saves the scheduler every checkpoint_interval ticks
+    size_t checkpoint_interval = kDefaultCheckpointInterval;
+    std::filesystem::path resume_file;  // --resume=<file> carries on from a checkpoint
+    std::string_view policy_name = zipline::GreedyPolicy::kName;
+    std::string stream_source;  // --stream=<file|-> plans orders as they arrive on a FIFO or stdin
+    zipline::StreamingOptions stream_options;
+    std::filesystem::path trace_file;  // --profile=<file> times every tick and writes a Chrome trace there
+    std::chrono::microseconds tick_budget = kDefaultTickBudget;
+    for (int i = 1; i < argc; ++i)
     {
-        assert(hospital_name == hospital.name());
-        std::cout << hospital.name() << " " << hospital.north() << " " << hospital.east() << std::endl;
+        const std::string_view arg{argv[i]};
+        if (arg.starts_with("--log=")) log_format = arg.substr(6);
+        if (arg == "--log-drop") log_overflow = zipline::LogOverflow::kDrop;
+        if (arg == "--kpi") print_kpis = true;
+        if (arg == "--batch-planning") batch_planning_moves = kDefaultBatchPlanningMoves;
+        if (arg.starts_with("--batch-planning=")) batch_planning_moves = std::stoul(std::string(arg.substr(17)));
+        if (arg.starts_with("--checkpoint=")) checkpoint_file = arg.substr(13);
+        if (arg.starts_with("--checkpoint-every=")) checkpoint_interval = std::stoul(std::string(arg.substr(19)));
+        if (arg.starts_with("--resume=")) resume_file = arg.substr(9);
+        if (arg.starts_with("--policy=")) policy_name = arg.substr(9);
+        if (arg.starts_with("--stream=")) stream_source = arg.substr(9);
+        if (arg.starts_with("--speed=")) stream_options.speedup = std::stod(std::string(arg.substr(8)));
+        if (arg.starts_with("--profile=")) trace_file = arg.substr(10);
+        if (arg.starts_with("--profile-budget-us="))
+        {
+            tick_budget = std::chrono::microseconds(std::stol(std::string(arg.substr(20))));
+        }
+        if (arg.starts_with("--stream-queue="))
+        {
+            stream_options.queue_capacity = std::stoul(std::string(arg.substr(15)));
+        }
+    }
+    if (!trace_file.empty() && !zipline::Profiler::kCompiledIn)
+    {
+        std::cerr << "--profile needs a build without ZIP_DISABLE_PROFILING" << std::endl;
+        return 1;
+    }
+    if (!stream_source.empty() && (!checkpoint_file.empty() || !resume_file.empty()))
+    {
+        std::cerr << "--stream does not support checkpoints" << std::endl;
+        return 1;
+    }
+    const auto policy = zipline::MakePolicy(policy_name);
+    if (!policy)
+    {
+        std::cerr << "Unknown policy " << policy_name << "; choose one of:";
+        for (const auto name : zipline::PolicyNames()) std::cerr << " " << name;
+        std::cerr << std::endl;
+        return 1;
     }
 
-    auto orders = Order::LoadOrders("../inputs/orders.csv", hospitals);
+    // an optional nests file switches on multi-nest scheduling; otherwise there is one nest at (0, 0)
+    const std::filesystem::path nests_file{"../inputs/nests.csv"};
+    zipline::SchedulerConfig config;
+    config.batch_planning.max_moves = batch_planning_moves;
+    auto hospitals = Hospital::LoadHospitals("../inputs/hospitals.csv", config.zip_speed,
+                                             std::filesystem::exists(nests_file) ? nests_file : std::filesystem::path{});
+    if (log_format == "text")
+    {
+        for (const auto &hospital : hospitals)
+        {
+            assert(hospitals.IdOf(hospital.name()) == hospital.id());
+            std::cout << hospital.name() << " " << hospital.north() << " " << hospital.east() << "\n";
+        }
+    }
 
-    zipline::ZipScheduler scheduler{};
-    scheduler.InitializeZips(kNumZips);
+    // declared before the scheduler so it outlives the planning threads that record into it
+    std::unique_ptr<zipline::Profiler> profiler;
+    if (!trace_file.empty()) profiler = std::make_unique<zipline::Profiler>(tick_budget);
 
-    size_t order_idx = 0;
-    const auto num_orders = orders.size();
+    zipline::ZipScheduler scheduler{hospitals, config};
+    scheduler.set_policy(*policy);
+    scheduler.set_profiler(profiler.get());
+    // declared after the scheduler's hospitals and before the run so it drains everything on the way out
+    auto event_log = MakeEventLog(log_format, log_overflow, hospitals);
+    scheduler.set_event_log(event_log.get());
 
-    auto first_timestamp = orders[order_idx].received_time();
+    zipline::Simulation simulation{scheduler, config.time_between_launches};
+    const size_t num_zips = config.num_zips * hospitals.num_nests();
+    zipline::DeliveryStats delivery_stats{num_zips};
+    simulation.set_delivery_stats(&delivery_stats);
+    simulation.set_launch_callback([num_zips](Timestamp, const std::vector<zipline::Flight> &flights) {
+        assert(flights.size() <= num_zips);
+        (void)flights;
+    });
 
-    for (Timestamp cur_time{first_timestamp}; cur_time < kSecondsPerDay; cur_time++)
+    if (!stream_source.empty())
+    {
+        zipline::StreamingDriver driver{scheduler, hospitals, config.time_between_launches, stream_options};
+        driver.set_delivery_stats(&delivery_stats);
+        std::ifstream stream_file;
+        if (stream_source != "-")
+        {
+            stream_file.open(stream_source);
+            if (!stream_file)
+            {
+                throw std::system_error(errno, std::generic_category(), "Could not open " + stream_source);
+            }
+        }
+        const bool from_stdin = stream_source == "-";
+        driver.Run(from_stdin ? std::cin : stream_file, from_stdin ? "<stdin>" : stream_source);
+        std::cerr << driver.num_orders() << " orders streamed (" << driver.num_rejected_lines()
+                  << " lines rejected, peak queue " << driver.peak_queue_depth() << "); launches on emergency "
+                  << driver.num_launches(zipline::LaunchTrigger::kEmergency) << ", zip return "
+                  << driver.num_launches(zipline::LaunchTrigger::kZipReturn) << ", grid "
+                  << driver.num_launches(zipline::LaunchTrigger::kGrid) << std::endl;
+    }
+    else
     {
-        while (order_idx < num_orders && orders[order_idx].received_time() <= cur_time)
+        // stream the orders in rather than loading them all, and run (across midnight if need be) until every
+        // order has been delivered
+        zipline::OrderReader orders{"../inputs/orders.csv", hospitals};
+        if (!checkpoint_file.empty()) simulation.set_checkpointing(checkpoint_file, checkpoint_interval);
+        if (resume_file.empty())
         {
-            scheduler.QueueOrder(orders[order_idx]);
-            order_idx++;
+            simulation.Run(orders, std::numeric_limits<Timestamp>::max());
         }
-        if (cur_time % kTimeBetweenLaunches == 0)
+        else
+        {
+            simulation.Resume(resume_file, orders, std::numeric_limits<Timestamp>::max());
+        }
+    }
+
+    if (print_kpis)
+    {
+        // drain the log first so the summary is not interleaved with it
+        scheduler.set_event_log(nullptr);
+        event_log.reset();
+        delivery_stats.Print(std::cout);
+    }
+
+    if (profiler)
+    {
+        profiler->PrintSummary(std::cerr);
+        std::ofstream trace{trace_file};
+        profiler->WriteChromeTrace(trace);
+        if (!trace.flush())
         {
-            auto flights = scheduler.LaunchFlights(cur_time);
-            assert(flights.size() <= kNumZips);
+            throw std::system_error(errno, std::generic_category(), "Could not write " + trace_file.string());
         }
     }
 
     return 0;
 }
+catch (const zipline::ParseError &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
+catch (const std::system_error &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
+catch (const zipline::CheckpointError &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
+catch (const std::invalid_argument &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
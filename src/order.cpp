@@ -3,39 +3,55 @@
 #include "order.h"
 
 #include <cassert>
-#include <fstream>
 
 #include "hospital.h"
 #include "util.h"
 
 namespace zipline
 {
-std::vector<Order> Order::LoadOrders(const std::filesystem::path &filename,
-                                     const std::unordered_map<std::string, Hospital> &hospitals)
+std::vector<Order> Order::LoadOrders(const std::filesystem::path &filename, const HospitalTable &hospitals)
 {
-    std::ifstream stream{filename};
-
     std::vector<Order> orders{};
+    OrderReader reader{filename, hospitals};
+    for (const Order &order : reader) orders.push_back(order);
+    return orders;
+}
 
-    Timestamp last_timestamp{0};
-    std::string line{};
-    while (std::getline(stream, line, '\n'))
-    {
-        auto tokens = ParseInputLine(line);
-        assert(tokens.size() == 3 && "Got wrong number of order elements");
+std::optional<Order> OrderReader::Next()
+{
+    if (!reader_.NextRow()) return std::nullopt;
 
-        Timestamp timestamp = atoi(tokens[0].c_str());
-        assert(timestamp >= last_timestamp && "Found order timestamps in decreasing order");
+    reader_.ExpectFields(3, "order");
 
-        orders.emplace_back(Order{timestamp, hospitals.at(tokens[1]), StringToPriority(tokens[2])});
+    const Timestamp timestamp = reader_.ParseInt(0, "received time");
+    if (timestamp < last_timestamp_) reader_.Fail("Found order timestamps in decreasing order");
 
-        last_timestamp = timestamp;
-    }
+    const auto hospital_id = hospitals_.Find(reader_.field(1));
+    if (!hospital_id) reader_.Fail("Unknown hospital '" + std::string(reader_.field(1)) + "'");
 
-    return orders;
+    const auto priority = Order::StringToPriority(reader_.field(2));
+    if (priority == Order::Priority::kUnknown) reader_.Fail("Unknown priority '" + std::string(reader_.field(2)) + "'");
+
+    last_timestamp_ = timestamp;
+    return Order{timestamp, *hospital_id, priority};
+}
+
+bool OrderReader::Skip(const uint64_t count)
+{
+    for (uint64_t i = 0; i < count; ++i)
+    {
+        if (!reader_.NextRow()) return false;
+    }
+    // keep checking the timestamps of the orders after the skipped ones
+    if (count > 0)
+    {
+        reader_.ExpectFields(3, "order");
+        last_timestamp_ = reader_.ParseInt(0, "received time");
+    }
+    return true;
 }
 
-Order::Priority Order::StringToPriority(const std::string &str)
+Order::Priority Order::StringToPriority(std::string_view str)
 {
     if (str == "Emergency")
     {
@@ -0,0 +1,89 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "order_index.h"
+
+#include <utility>
+
+namespace zipline
+{
+size_t OrderIndex::HomeSlot(const OrderId id) const
+{
+    return static_cast<size_t>((id * 0x9E3779B97F4A7C15ull) >> shift_);
+}
+
+// Slot holding id, or the empty slot where it would go.
+size_t OrderIndex::FindSlot(const OrderId id) const
+{
+    const size_t mask = slots_.size() - 1;
+    size_t slot = HomeSlot(id);
+    while (slots_[slot].id != id && slots_[slot].id != kEmptySlot) slot = (slot + 1) & mask;
+    return slot;
+}
+
+void OrderIndex::Insert(const OrderId id, const OrderLocation &location)
+{
+    if (2 * (size_ + 1) > slots_.size()) Grow();
+    Slot &slot = slots_[FindSlot(id)];
+    if (slot.id == kEmptySlot) size_++;
+    slot.id = id;
+    slot.location = location;
+}
+
+OrderLocation *OrderIndex::Find(const OrderId id)
+{
+    if (size_ == 0) return nullptr;
+    Slot &slot = slots_[FindSlot(id)];
+    return slot.id == id ? &slot.location : nullptr;
+}
+
+void OrderIndex::Erase(const OrderId id)
+{
+    if (size_ == 0) return;
+    const size_t slot = FindSlot(id);
+    if (slots_[slot].id == id) EraseSlot(slot);
+}
+
+/*
+    Description: Empties a slot and shifts back every entry of the probe run after it that would otherwise no
+                 longer be reachable from its home slot, so lookups never need tombstones.
+    Arguments:
+        - slot: index of a used slot
+*/
+void OrderIndex::EraseSlot(const size_t slot)
+{
+    const size_t mask = slots_.size() - 1;
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; slots_[next].id != kEmptySlot; next = (next + 1) & mask)
+    {
+        // the entry may fill the hole unless its home slot lies after the hole in the run
+        if (((next - HomeSlot(slots_[next].id)) & mask) >= ((next - hole) & mask))
+        {
+            slots_[hole] = slots_[next];
+            hole = next;
+        }
+    }
+    slots_[hole] = Slot{};
+    size_--;
+}
+
+void OrderIndex::Clear()
+{
+    for (auto &slot : slots_) slot = Slot{};
+    size_ = 0;
+}
+
+void OrderIndex::Grow()
+{
+    std::vector<Slot> old_slots(slots_.empty() ? kMinSlots : 2 * slots_.size());
+    std::swap(old_slots, slots_);
+    shift_ = 64;
+    for (size_t num_slots = slots_.size(); num_slots > 1; num_slots >>= 1) shift_--;
+
+    size_ = 0;
+    for (const auto &slot : old_slots)
+    {
+        if (slot.id != kEmptySlot) Insert(slot.id, slot.location);
+    }
+}
+
+}  // namespace zipline
@@ -0,0 +1,238 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "order_queue.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace zipline
+{
+void OrderQueue::Reserve(const size_t capacity)
+{
+    nodes_.reserve(capacity);
+    heap_.reserve(capacity);
+}
+
+OrderHandle OrderQueue::Push(const Order &order)
+{
+    return Push(order, next_seq_);
+}
+
+OrderHandle OrderQueue::Push(const Order &order, const uint64_t seq)
+{
+    return Push(order, seq, order.received_time() + time_to_deadline_);
+}
+
+OrderHandle OrderQueue::Push(const Order &order, const uint64_t seq, const Timestamp deadline)
+{
+    assert(order.hospital_id() < buckets_.size() && "Order for unknown hospital");
+    next_seq_ = std::max(next_seq_, seq + 1);
+
+    OrderHandle handle = free_head_;
+    if (handle != kInvalidOrderHandle)
+    {
+        free_head_ = nodes_[handle].bucket_next;
+    }
+    else
+    {
+        assert(nodes_.size() < kInvalidOrderHandle && "Order arena is full");
+        handle = static_cast<OrderHandle>(nodes_.size());
+        nodes_.emplace_back();
+    }
+
+    // keep the bucket oldest first; only an order re-pushed with an older sequence number, such as one moved
+    // between tiers, walks back past the tail
+    Bucket &bucket = buckets_[order.hospital_id()];
+    OrderHandle prev = bucket.tail;
+    while (prev != kInvalidOrderHandle && nodes_[prev].seq > seq) prev = nodes_[prev].bucket_prev;
+    const OrderHandle next = prev != kInvalidOrderHandle ? nodes_[prev].bucket_next : bucket.head;
+
+    const auto heap_index = static_cast<uint32_t>(heap_.size());
+    nodes_[handle] = Node{order, seq, deadline, heap_index, prev, next};
+    heap_.push_back(handle);
+    SiftUp(heap_index);
+
+    if (prev != kInvalidOrderHandle) nodes_[prev].bucket_next = handle;
+    else bucket.head = handle;
+    if (next != kInvalidOrderHandle) nodes_[next].bucket_prev = handle;
+    else bucket.tail = handle;
+    return handle;
+}
+
+size_t OrderQueue::MostUrgent(const std::span<OrderHandle> handles) const
+{
+    assert(handles.size() <= kMaxMostUrgent && "Too many orders asked for");
+
+    // every order is less urgent than its parent in the heap, so the next most urgent one is always the root or a
+    // child of one already taken; each one taken adds at most one entry to the frontier
+    std::array<uint32_t, kMaxMostUrgent + 1> frontier;  // heap indexes
+    size_t frontier_size = heap_.empty() ? 0 : 1;
+    frontier[0] = 0;
+    size_t num_handles = 0;
+    while (num_handles < handles.size() && frontier_size > 0)
+    {
+        size_t best = 0;
+        for (size_t i = 1; i < frontier_size; ++i)
+        {
+            if (MoreUrgent(heap_[frontier[i]], heap_[frontier[best]])) best = i;
+        }
+        const uint32_t index = frontier[best];
+        frontier[best] = frontier[--frontier_size];
+        handles[num_handles++] = heap_[index];
+        for (uint32_t child = 2 * index + 1; child <= 2 * index + 2 && child < heap_.size(); ++child)
+        {
+            frontier[frontier_size++] = child;
+        }
+    }
+    return num_handles;
+}
+
+Order OrderQueue::PopFront()
+{
+    assert(!empty() && "Queue is empty");
+    return Remove(heap_.front());
+}
+
+Order OrderQueue::PopFrom(const HospitalId hospital)
+{
+    assert(buckets_[hospital].head != kInvalidOrderHandle && "No pending order for hospital");
+    return Remove(buckets_[hospital].head);
+}
+
+Order OrderQueue::Remove(const OrderHandle handle)
+{
+    Node &node = nodes_[handle];
+    Bucket &bucket = buckets_[node.order.hospital_id()];
+
+    // move the last heap entry into the hole and restore the heap in whichever direction it is out of place
+    const uint32_t index = node.heap_index;
+    const OrderHandle last = heap_.back();
+    heap_.pop_back();
+    if (last != handle)
+    {
+        heap_[index] = last;
+        nodes_[last].heap_index = index;
+        SiftUp(index);
+        SiftDown(nodes_[last].heap_index);
+    }
+
+    if (node.bucket_prev != kInvalidOrderHandle) nodes_[node.bucket_prev].bucket_next = node.bucket_next;
+    else bucket.head = node.bucket_next;
+    if (node.bucket_next != kInvalidOrderHandle) nodes_[node.bucket_next].bucket_prev = node.bucket_prev;
+    else bucket.tail = node.bucket_prev;
+
+    node.bucket_next = free_head_;
+    free_head_ = handle;
+    return node.order;
+}
+
+void OrderQueue::SetDeadline(const OrderHandle handle, const Timestamp deadline)
+{
+    nodes_[handle].deadline = deadline;
+    SiftUp(nodes_[handle].heap_index);
+    SiftDown(nodes_[handle].heap_index);
+}
+
+void OrderQueue::SiftUp(uint32_t index)
+{
+    const OrderHandle handle = heap_[index];
+    while (index > 0)
+    {
+        const uint32_t parent = (index - 1) / 2;
+        if (!MoreUrgent(handle, heap_[parent])) break;
+        heap_[index] = heap_[parent];
+        nodes_[heap_[index]].heap_index = index;
+        index = parent;
+    }
+    heap_[index] = handle;
+    nodes_[handle].heap_index = index;
+}
+
+void OrderQueue::SiftDown(uint32_t index)
+{
+    const OrderHandle handle = heap_[index];
+    const auto size = static_cast<uint32_t>(heap_.size());
+    while (true)
+    {
+        uint32_t child = 2 * index + 1;
+        if (child >= size) break;
+        if (child + 1 < size && MoreUrgent(heap_[child + 1], heap_[child])) child++;
+        if (!MoreUrgent(heap_[child], handle)) break;
+        heap_[index] = heap_[child];
+        nodes_[heap_[index]].heap_index = index;
+        index = child;
+    }
+    heap_[index] = handle;
+    nodes_[handle].heap_index = index;
+}
+
+/*
+    Description: Walks the precomputed neighbor list of `from` in distance order and returns the first hospital with a
+                 pending order. Hospitals at the same distance are resolved in favour of the one whose order arrived
+                 first, matching a linear scan of the queue in arrival order.
+    Arguments:
+        - hospitals: table providing neighbor lists and leg distances
+        - from: node (hospital or nest) the zip is currently at
+    Returns: The nearest hospital with a pending order, or nullopt if there are none.
+*/
+std::optional<HospitalId> OrderQueue::NearestHospital(const HospitalTable &hospitals, const HospitalId from,
+                                                      size_t *num_scanned) const
+{
+    if (empty()) return std::nullopt;
+
+    std::optional<HospitalId> nearest;
+    size_t num_visited = 0;
+    for (HospitalId hospital : hospitals.NeighborsByDistance(from))
+    {
+        num_visited++;
+        const OrderHandle head = buckets_[hospital].head;
+        if (head == kInvalidOrderHandle) continue;
+        if (!nearest)
+        {
+            nearest = hospital;
+            continue;
+        }
+        if (hospitals.Distance(from, hospital) != hospitals.Distance(from, *nearest)) break;
+        if (nodes_[head].seq < nodes_[buckets_[*nearest].head].seq) nearest = hospital;
+    }
+    if (num_scanned) *num_scanned += num_visited;
+    return nearest;
+}
+
+void OrderQueue::Save(CheckpointWriter &writer) const
+{
+    std::vector<OrderHandle> by_arrival(heap_);
+    std::sort(by_arrival.begin(), by_arrival.end(),
+              [this](OrderHandle a, OrderHandle b) { return nodes_[a].seq < nodes_[b].seq; });
+    writer.Write(static_cast<uint64_t>(by_arrival.size()));
+    for (const OrderHandle handle : by_arrival)
+    {
+        writer.WriteOrder(nodes_[handle].order);
+        writer.Write(nodes_[handle].seq);
+        writer.Write(nodes_[handle].deadline);
+    }
+}
+
+// Buckets are kept in sequence order, so pushing the orders back oldest first with their own sequence numbers rebuilds
+// the same buckets and ties between equal deadlines and between hospitals at the same distance still break the same
+// way.
+void OrderQueue::Load(CheckpointReader &reader)
+{
+    *this = OrderQueue(buckets_.size(), time_to_deadline_);
+    const auto num_orders = reader.Read<uint64_t>();
+    for (uint64_t i = 0; i < num_orders; ++i)
+    {
+        const Order order = reader.ReadOrder();
+        reader.Expect(order.hospital_id() < buckets_.size(), "order for unknown hospital");
+        reader.Expect(order.priority() != Order::Priority::kUnknown &&
+                          static_cast<size_t>(order.priority()) < Order::kNumPriorities,
+                      "order of unknown priority");
+        const auto seq = reader.Read<uint64_t>();
+        const auto deadline = reader.Read<Timestamp>();
+        reader.Expect(seq >= next_seq_, "orders out of sequence");
+        Push(order, seq, deadline);
+    }
+}
+
+}  // namespace zipline
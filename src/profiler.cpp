@@ -0,0 +1,207 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace zipline
+{
+namespace
+{
+std::atomic<uint64_t> next_instance_id{1};
+
+// The calling thread's buffer in the profiler it last recorded into.
+struct LocalBufferCache
+{
+    uint64_t instance_id{0};
+    void *buffer{nullptr};
+};
+thread_local LocalBufferCache local_buffer_cache;
+
+constexpr std::array<std::string_view, static_cast<size_t>(ProfilePhase::kCount)> kPhaseNames{
+    "tick", "drain intake", "plan nest", "free zips", "pick anchor", "build route", "queue erase", "batch plan",
+    "commit"};
+
+constexpr std::array<std::string_view, static_cast<size_t>(ProfileCounter::kCount)> kCounterNames{
+    "candidates/flight", "stops/flight", "flights/tick", "orders drained/tick", "queue depth/nest"};
+}  // namespace
+
+Profiler::Profiler(const std::chrono::nanoseconds tick_budget, const size_t max_trace_events)
+    : start_(std::chrono::steady_clock::now()),
+      tick_budget_ns_(static_cast<uint64_t>(std::max<int64_t>(0, tick_budget.count()))),
+      max_trace_events_(max_trace_events),
+      instance_id_(next_instance_id.fetch_add(1, std::memory_order_relaxed))
+{
+    slowest_ticks_.reserve(kMaxSlowTicks);
+}
+
+Profiler::~Profiler() = default;
+
+// The buffer is found through a thread-local cache keyed by the profiler's instance id, so recording only takes the
+// registry lock the first time a thread records into this profiler.
+Profiler::ThreadBuffer &Profiler::LocalBuffer()
+{
+    if (local_buffer_cache.instance_id == instance_id_) return *static_cast<ThreadBuffer *>(local_buffer_cache.buffer);
+
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    auto &buffer = buffers_.emplace_back(std::make_unique<ThreadBuffer>());
+    buffer->thread_idx = buffers_.size() - 1;
+    local_buffer_cache = LocalBufferCache{instance_id_, buffer.get()};
+    return *buffer;
+}
+
+void Profiler::RecordPhase(const ProfilePhase phase, const uint64_t start_ns, const uint64_t end_ns)
+{
+    Record(phase, start_ns, end_ns, 0);
+}
+
+void Profiler::Record(const ProfilePhase phase, const uint64_t start_ns, const uint64_t end_ns,
+                      const Timestamp tick_time)
+{
+    const size_t phase_idx = static_cast<size_t>(phase);
+    const uint64_t duration_ns = end_ns - start_ns;
+    ThreadBuffer &buffer = LocalBuffer();
+    {
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+        buffer.phases[phase_idx].Record(duration_ns);
+        if (num_trace_events_.fetch_add(1, std::memory_order_relaxed) < max_trace_events_)
+        {
+            buffer.events.push_back(TraceEvent{start_ns, duration_ns, phase, tick_time});
+        }
+        else
+        {
+            num_dropped_events_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    tick_phase_ns_[phase_idx].fetch_add(duration_ns, std::memory_order_relaxed);
+}
+
+void Profiler::Count(const ProfileCounter counter, const uint64_t value)
+{
+    ThreadBuffer &buffer = LocalBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.counters[static_cast<size_t>(counter)].Record(value);
+}
+
+void Profiler::BeginTick()
+{
+    for (auto &phase_ns : tick_phase_ns_) phase_ns.store(0, std::memory_order_relaxed);
+}
+
+void Profiler::EndTick(const Timestamp time, const uint64_t start_ns, const uint64_t end_ns)
+{
+    Record(ProfilePhase::kTick, start_ns, end_ns, time);
+    num_ticks_++;
+
+    const uint64_t duration_ns = end_ns - start_ns;
+    if (duration_ns <= tick_budget_ns_) return;
+    num_slow_ticks_++;
+
+    // keep the slowest ticks, with the fastest of them at the front of the heap
+    const auto slower = [](const SlowTick &a, const SlowTick &b) { return a.duration_ns > b.duration_ns; };
+    if (slowest_ticks_.size() == kMaxSlowTicks)
+    {
+        if (duration_ns <= slowest_ticks_.front().duration_ns) return;
+        std::pop_heap(slowest_ticks_.begin(), slowest_ticks_.end(), slower);
+        slowest_ticks_.pop_back();
+    }
+    SlowTick tick{time, duration_ns, {}};
+    for (size_t i = 0; i < kNumPhases; ++i) tick.phase_ns[i] = tick_phase_ns_[i].load(std::memory_order_relaxed);
+    slowest_ticks_.push_back(tick);
+    std::push_heap(slowest_ticks_.begin(), slowest_ticks_.end(), slower);
+}
+
+void Profiler::PrintSummary(std::ostream &stream) const
+{
+    std::array<Histogram, kNumPhases> phases;
+    std::array<Histogram, kNumCounters> counters;
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        for (const auto &buffer : buffers_)
+        {
+            std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+            for (size_t i = 0; i < kNumPhases; ++i) phases[i].Merge(buffer->phases[i]);
+            for (size_t i = 0; i < kNumCounters; ++i) counters[i].Merge(buffer->counters[i]);
+        }
+    }
+
+    const auto flags = stream.flags();
+    stream << std::fixed << std::setprecision(1);
+    stream << "Phase (ns)           " << std::setw(10) << "count" << std::setw(10) << "mean" << std::setw(10) << "p50"
+           << std::setw(10) << "p99" << std::setw(10) << "max" << std::setw(12) << "total ms" << "\n";
+    for (size_t i = 0; i < kNumPhases; ++i)
+    {
+        const Histogram &times = phases[i];
+        if (times.count() == 0) continue;
+        stream << std::left << std::setw(21) << kPhaseNames[i] << std::right << std::setw(10) << times.count()
+               << std::setw(10) << times.mean() << std::setw(10) << times.Percentile(0.5) << std::setw(10)
+               << times.Percentile(0.99) << std::setw(10) << times.max() << std::setw(12) << times.sum() / 1e6
+               << "\n";
+    }
+    stream << "Counter              " << std::setw(10) << "count" << std::setw(10) << "mean" << std::setw(10) << "p50"
+           << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+    for (size_t i = 0; i < kNumCounters; ++i)
+    {
+        const Histogram &values = counters[i];
+        if (values.count() == 0) continue;
+        stream << std::left << std::setw(21) << kCounterNames[i] << std::right << std::setw(10) << values.count()
+               << std::setw(10) << values.mean() << std::setw(10) << values.Percentile(0.5) << std::setw(10)
+               << values.Percentile(0.99) << std::setw(10) << values.max() << "\n";
+    }
+
+    stream << "Ticks over the " << tick_budget_ns_ / 1e3 << " us budget: " << num_slow_ticks_ << " of " << num_ticks_
+           << "\n";
+    std::vector<SlowTick> slowest(slowest_ticks_);
+    std::sort(slowest.begin(), slowest.end(),
+              [](const SlowTick &a, const SlowTick &b) { return a.duration_ns > b.duration_ns; });
+    for (const auto &tick : slowest)
+    {
+        // phases nest, so each is shown inclusive of the ones inside it, and nests planned in parallel add up
+        std::array<size_t, kNumPhases> by_time;
+        for (size_t i = 0; i < kNumPhases; ++i) by_time[i] = i;
+        std::sort(by_time.begin() + 1, by_time.end(),
+                  [&tick](size_t a, size_t b) { return tick.phase_ns[a] > tick.phase_ns[b]; });
+
+        stream << "  t=" << tick.time << " " << tick.duration_ns / 1e3 << " us:";
+        const char *separator = " ";
+        for (size_t i = 1; i <= kMaxPhasesPerTick && tick.phase_ns[by_time[i]] > 0; ++i)
+        {
+            stream << separator << kPhaseNames[by_time[i]] << " " << tick.phase_ns[by_time[i]] / 1e3 << " us";
+            separator = ", ";
+        }
+        stream << "\n";
+    }
+
+    const size_t num_dropped = num_dropped_events_.load(std::memory_order_relaxed);
+    if (num_dropped > 0) stream << num_dropped << " trace events past the limit were not kept\n";
+    stream.flags(flags);
+}
+
+void Profiler::WriteChromeTrace(std::ostream &stream) const
+{
+    const auto flags = stream.flags();
+    stream << std::fixed << std::setprecision(3);
+    stream << "{\"traceEvents\":[\n";
+    const char *separator = "";
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    for (const auto &buffer : buffers_)
+    {
+        std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+        stream << separator << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->thread_idx
+               << R"(,"args":{"name":"scheduler )" << buffer->thread_idx << "\"}}";
+        separator = ",\n";
+        for (const auto &event : buffer->events)
+        {
+            stream << separator << R"({"name":")" << kPhaseNames[static_cast<size_t>(event.phase)]
+                   << R"(","cat":"scheduler","ph":"X","pid":1,"tid":)" << buffer->thread_idx
+                   << ",\"ts\":" << event.start_ns / 1e3 << ",\"dur\":" << event.duration_ns / 1e3;
+            if (event.phase == ProfilePhase::kTick) stream << R"(,"args":{"time":)" << event.tick_time << "}";
+            stream << "}";
+        }
+    }
+    stream << "\n]}\n";
+    stream.flags(flags);
+}
+
+}  // namespace zipline
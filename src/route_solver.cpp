@@ -0,0 +1,168 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "route_solver.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <numeric>
+
+namespace zipline
+{
+namespace
+{
+// above every HospitalId, so no hospital's stop can be mistaken for an emergency one
+constexpr uint32_t kEmergencyBit = 1u << 16;
+constexpr uint32_t kUnusedStop = std::numeric_limits<uint32_t>::max();
+
+static_assert(std::numeric_limits<HospitalId>::max() < kEmergencyBit, "HospitalId overlaps the emergency flag");
+
+static_assert(kMaxRouteStops == 4, "Add a SolveExact case for every supported stop count");
+
+HospitalId KeyHospital(uint32_t key_stop)
+{
+    return static_cast<HospitalId>(key_stop & ~kEmergencyBit);
+}
+}  // namespace
+
+size_t RouteSolver::HashKey(const RouteKey &key)
+{
+    uint64_t hash = 1469598103934665603ull;  // FNV-1a
+    for (uint32_t node : key)
+    {
+        hash ^= node;
+        hash *= 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+/*
+    Description: Enumerates every visiting order of N stops, keeping those that serve all emergency stops before
+                 any resupply stop, and returns the shortest loop. N is a compile-time constant so the permutation
+                 loop is fully unrolled for the small flights zips actually fly.
+    Arguments:
+        - nest: node the loop starts and ends at
+        - key: route key; key[1..N] are the stops, emergency stops first
+    Returns: Shortest route, with stop_order indexing key[1..N].
+*/
+template <size_t N>
+Route RouteSolver::SolveExact(const HospitalId nest, const RouteKey &key) const
+{
+    std::array<uint8_t, N> perm;
+    std::iota(perm.begin(), perm.end(), 0);
+
+    Route best;
+    best.distance = std::numeric_limits<int>::max();
+    best.num_stops = N;
+    do
+    {
+        bool valid = true;
+        int dist = 0;
+        HospitalId prev = nest;
+        for (size_t i = 0; i < N; ++i)
+        {
+            const uint32_t stop = key[perm[i] + 1];
+            if (i > 0 && (stop & kEmergencyBit) && !(key[perm[i - 1] + 1] & kEmergencyBit))
+            {
+                valid = false;  // an emergency stop may not follow a resupply stop
+                break;
+            }
+            dist += hospitals_.Distance(prev, KeyHospital(stop));
+            prev = KeyHospital(stop);
+        }
+        if (!valid) continue;
+        dist += hospitals_.Distance(prev, nest);
+        if (dist < best.distance)
+        {
+            best.distance = dist;
+            std::copy(perm.begin(), perm.end(), best.stop_order.begin());
+        }
+    } while (std::next_permutation(perm.begin(), perm.end()));
+
+    return best;
+}
+
+RouteSolver::RouteKey RouteSolver::MakeKey(const HospitalId nest, const std::span<const Order> stops,
+                                           std::array<uint8_t, kMaxRouteStops> &sorted)
+{
+    const size_t num_stops = stops.size();
+    assert(num_stops > 0 && num_stops <= kMaxRouteStops && "Unsupported number of stops");
+
+    // canonical stop order: emergency first, then by hospital, so equivalent flights share a cache entry
+    std::iota(sorted.begin(), sorted.begin() + num_stops, 0);
+    auto key_stop = [&stops](size_t i) -> uint32_t {
+        const bool emergency = stops[i].priority() == Order::Priority::kEmergency;
+        return static_cast<uint32_t>(stops[i].hospital_id()) | (emergency ? kEmergencyBit : 0);
+    };
+    for (size_t i = 1; i < num_stops; ++i)  // insertion sort; there are only a handful of stops
+    {
+        for (size_t j = i; j > 0 && (key_stop(sorted[j]) ^ kEmergencyBit) < (key_stop(sorted[j - 1]) ^ kEmergencyBit);
+             --j)
+        {
+            std::swap(sorted[j], sorted[j - 1]);
+        }
+    }
+
+    RouteKey key;
+    key.fill(kUnusedStop);
+    key[0] = nest;
+    for (size_t i = 0; i < num_stops; ++i) key[i + 1] = key_stop(sorted[i]);
+    return key;
+}
+
+Route RouteSolver::SolveKey(const HospitalId nest, const RouteKey &key, const size_t num_stops) const
+{
+    switch (num_stops)
+    {
+        case 1:
+            return SolveExact<1>(nest, key);
+        case 2:
+            return SolveExact<2>(nest, key);
+        case 3:
+            return SolveExact<3>(nest, key);
+        case 4:
+            return SolveExact<4>(nest, key);
+    }
+    assert(0 && "Unsupported number of stops");
+    return {};
+}
+
+/*
+    Description: Returns the shortest loop from the nest through every stop, serving emergency stops first. The
+                 result for a given set of stops is computed once and then served from the cache.
+    Arguments:
+        - nest: node the loop starts and ends at
+        - stops: orders on the flight, in any order
+    Returns: Route whose stop_order indexes into stops.
+*/
+Route RouteSolver::Solve(const HospitalId nest, const std::span<const Order> stops)
+{
+    std::array<uint8_t, kMaxRouteStops> sorted{};
+    const RouteKey key = MakeKey(nest, stops, sorted);
+
+    CacheSlot &slot = cache_[HashKey(key) & (kNumCacheSlots - 1)];
+    if (!slot.filled || slot.key != key)
+    {
+        num_cached_ += !slot.filled;
+        slot.filled = true;
+        slot.key = key;
+        slot.route = SolveKey(nest, key, stops.size());
+    }
+
+    // translate from canonical positions back to the caller's indices
+    Route route = slot.route;
+    for (size_t i = 0; i < stops.size(); ++i) route.stop_order[i] = sorted[route.stop_order[i]];
+    return route;
+}
+
+Route RouteSolver::SolveUncached(const HospitalId nest, const std::span<const Order> stops) const
+{
+    std::array<uint8_t, kMaxRouteStops> sorted{};
+    const RouteKey key = MakeKey(nest, stops, sorted);
+
+    Route route = SolveKey(nest, key, stops.size());
+    for (size_t i = 0; i < stops.size(); ++i) route.stop_order[i] = sorted[route.stop_order[i]];
+    return route;
+}
+
+}  // namespace zipline
@@ -0,0 +1,314 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "scheduling_policy.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace zipline
+{
+namespace
+{
+template <typename Variant, size_t... Index>
+std::optional<Variant> MakeAlternative(std::string_view name, std::index_sequence<Index...>)
+{
+    std::optional<Variant> policy;
+    ((std::variant_alternative_t<Index, Variant>::kName == name
+          ? (void)policy.emplace(std::in_place_index<Index>)
+          : (void)0),
+     ...);
+    return policy;
+}
+
+template <typename Variant, size_t... Index>
+std::vector<std::string_view> AlternativeNames(std::index_sequence<Index...>)
+{
+    return {std::variant_alternative_t<Index, Variant>::kName...};
+}
+
+// Expected min(cap, X) for X ~ Poisson(mean): how many of the orders arriving fit in cap free slots.
+double ExpectedArrivalsUpTo(const double mean, const int cap)
+{
+    double pmf = std::exp(-mean);  // P(X = k)
+    double cdf = pmf;              // P(X <= k)
+    double expected = 0.0;
+    for (int k = 0; k < cap; ++k)
+    {
+        expected += 1.0 - cdf;
+        pmf *= mean / (k + 1);
+        cdf += pmf;
+    }
+    return expected;
+}
+}  // namespace
+
+static_assert(SchedulingPolicy<GreedyPolicy>);
+static_assert(SchedulingPolicy<NearestNeighborPolicy>);
+static_assert(SchedulingPolicy<LookaheadPolicy>);
+
+std::optional<AnyPolicy> MakePolicy(const std::string_view name)
+{
+    return MakeAlternative<AnyPolicy>(name, std::make_index_sequence<std::variant_size_v<AnyPolicy>>{});
+}
+
+std::vector<std::string_view> PolicyNames()
+{
+    return AlternativeNames<AnyPolicy>(std::make_index_sequence<std::variant_size_v<AnyPolicy>>{});
+}
+
+// A tier launches once it has a full batch or its most urgent order is due, up to its flights per tick.
+bool GreedyPolicy::ShouldLaunch(NestContext &nest, const Order::Priority tier, const int num_flights,
+                                const Timestamp current_time) const
+{
+    const PriorityTier &rules = nest.config.tier(tier);
+    if (rules.max_flights_per_tick > 0 && num_flights >= rules.max_flights_per_tick) return false;
+    const OrderQueue &orders = nest.queue(tier);
+    return orders.size() >= rules.min_batch || orders.front_deadline() <= current_time;
+}
+
+// Reduced range zips keep the flights of tiers that ask for it to a reduced_range_time round trip, to be back sooner
+// for any emergencies; other flights can use the max range.
+int GreedyPolicy::FlightRange(NestContext &nest, const Order::Priority tier, const int zip_idx) const
+{
+    const bool reduced =
+        nest.config.tier(tier).reduced_range && nest.fleet.range_class(zip_idx) == RangeClass::kReduced;
+    return reduced ? nest.config.reduced_range() : nest.config.max_range;
+}
+
+// The tier's most urgent order: the earliest deadline, oldest first.
+Order GreedyPolicy::PickAnchor(NestContext &nest, const Order::Priority tier) const
+{
+    ZIP_PROFILE_SCOPE(nest.profiler, ProfilePhase::kQueueErase);
+    return nest.queue(tier).PopFront();
+}
+
+/*
+    Description: Performs order scheduling for a zip by maximizing the amount of packages it can deliver within its
+                 range. Starting from the anchor, it searches through the other orders (most urgent tier first) and
+                 adds those closest to the current order location.
+    Arguments:
+        - nest: nest the zip flies from
+        - stops: holds the anchor; receives the other stops, in visiting order
+        - max_range: max distance for the zip (either reduced or max)
+    Returns: The loop distance of the flight.
+*/
+int GreedyPolicy::BuildRoute(NestContext &nest, std::vector<Order> &stops, const int max_range) const
+{
+    return GrowRoute(nest, stops, [&](RouteState &state) {
+        std::optional<Order> min_order;
+        for (const auto priority : Order::kPrioritiesByUrgency)
+        {
+            min_order = TakeNearestInQueue(nest, stops, state, max_range, nest.queue(priority));
+            if (min_order) break;
+        }
+        return min_order;
+    });
+}
+
+/*
+    Description: Grows a flight from its anchor until next_stop finds nothing more or the zip is full, then flies
+                 the stops in the shortest order (serving emergencies first) if that beats the nearest-next chain.
+    Arguments:
+        - nest: nest the zip flies from
+        - stops: holds the anchor; receives the other stops, in visiting order
+        - next_stop: takes the next order to add out of its queue and advances the RouteState, or returns nullopt
+    Returns: The loop distance of the flight.
+*/
+template <typename NextStop>
+int GreedyPolicy::GrowRoute(NestContext &nest, std::vector<Order> &stops, NextStop next_stop) const
+{
+    const HospitalId anchor = stops.front().hospital_id();
+    RouteState state{anchor, nest.hospitals.Distance(nest.node, anchor), nest.hospitals.Distance(anchor, nest.node)};
+
+    // add any nearby orders up to range and package capacity
+    while (stops.size() < static_cast<size_t>(nest.config.max_packages))
+    {
+        std::optional<Order> order = next_stop(state);
+        if (!order) break;
+        stops.push_back(*order);
+    }
+    int distance = state.curr_dist + state.return_dist;  // total distance of the orders in the order they were picked
+
+    // fly the stops in the shortest order if that beats the nearest-next chain
+    if (stops.size() <= kMaxRouteStops)
+    {
+        const Route route = nest.routes.Solve(nest.node, stops);
+        if (route.distance < distance)
+        {
+            std::array<Order, kMaxRouteStops> picked;
+            std::copy(stops.begin(), stops.end(), picked.begin());
+            for (size_t i = 0; i < stops.size(); ++i) stops[i] = picked[route.stop_order[i]];
+            distance = route.distance;
+        }
+    }
+    return distance;
+}
+
+/*
+    Description: Gets the order location (hospital) that is closest to the current one, ensuring zip can both reach and
+                 return to nest from there. Only hospitals with pending orders are considered. An order that does not
+                 fit at the end of the nearest-next chain is still taken if some other visiting order of the stops
+                 fits within range.
+    Arguments:
+        - nest: nest the zip has to return to
+        - stops: orders already on the flight; used (and restored) to evaluate the best visiting order
+        - state: position of the flight so far, advanced past the order taken
+        - max_range: max distance for zip
+        - orders: queue of one priority tier to search through
+    Returns: The nearest order or nullopt if none is within range.
+*/
+std::optional<Order> GreedyPolicy::TakeNearestInQueue(NestContext &nest, std::vector<Order> &stops,
+                                                      RouteState &state, const int max_range,
+                                                      OrderQueue &orders) const
+{
+    std::optional<HospitalId> next_node =
+        orders.NearestHospital(nest.hospitals, state.curr_node, &nest.num_scanned);
+    if (!next_node) return std::nullopt;  // no pending orders in this queue
+
+    const int min_dist = nest.hospitals.Distance(state.curr_node, *next_node);
+    // distance from hospital of next order to nest
+    const int dist_next_to_nest = nest.hospitals.Distance(*next_node, nest.node);
+
+    // check if zip can make it back home
+    bool in_range = state.curr_dist + min_dist + dist_next_to_nest < max_range;
+    if (!in_range && stops.size() < kMaxRouteStops)
+    {
+        stops.push_back(orders.PeekFrom(*next_node));
+        in_range = nest.routes.Solve(nest.node, stops).distance < max_range;
+        stops.pop_back();
+    }
+    if (!in_range) return std::nullopt;
+
+    state.curr_node = *next_node;
+    state.return_dist = dist_next_to_nest;
+    state.curr_dist += min_dist;
+    ZIP_PROFILE_SCOPE(nest.profiler, ProfilePhase::kQueueErase);
+    return orders.PopFrom(*next_node);
+}
+
+// Tries each tier's nearest order closest first, more urgent tiers first among equally close ones.
+int NearestNeighborPolicy::BuildRoute(NestContext &nest, std::vector<Order> &stops, const int max_range) const
+{
+    return GrowRoute(nest, stops, [&](RouteState &state) {
+        std::array<std::pair<int, Order::Priority>, Order::kPrioritiesByUrgency.size()> candidates;
+        size_t num_candidates = 0;
+        for (const auto priority : Order::kPrioritiesByUrgency)
+        {
+            const std::optional<HospitalId> nearest =
+                nest.queue(priority).NearestHospital(nest.hospitals, state.curr_node, &nest.num_scanned);
+            if (nearest) candidates[num_candidates++] = {nest.hospitals.Distance(state.curr_node, *nearest), priority};
+        }
+        // stable insertion sort; std::stable_sort would allocate a buffer for a handful of tiers
+        for (size_t i = 1; i < num_candidates; ++i)
+        {
+            for (size_t j = i; j > 0 && candidates[j].first < candidates[j - 1].first; --j)
+            {
+                std::swap(candidates[j], candidates[j - 1]);
+            }
+        }
+
+        for (size_t i = 0; i < num_candidates; ++i)
+        {
+            std::optional<Order> order =
+                TakeNearestInQueue(nest, stops, state, max_range, nest.queue(candidates[i].second));
+            if (order) return order;
+        }
+        return std::optional<Order>{};
+    });
+}
+
+// Launches whenever greedy would and some candidate anchor is not worth holding; PickAnchor then takes that one.
+bool LookaheadPolicy::ShouldLaunch(NestContext &nest, const Order::Priority tier, const int num_flights,
+                                   const Timestamp current_time) const
+{
+    nest.anchor = kInvalidOrderHandle;
+    if (!GreedyPolicy::ShouldLaunch(nest, tier, num_flights, current_time)) return false;
+    nest.anchor = FindAnchor(nest, tier, current_time);
+    return nest.anchor != kInvalidOrderHandle;
+}
+
+// The anchor ShouldLaunch chose, taken out of its queue.
+Order LookaheadPolicy::PickAnchor(NestContext &nest, const Order::Priority tier) const
+{
+    if (nest.anchor == kInvalidOrderHandle) return GreedyPolicy::PickAnchor(nest, tier);
+    ZIP_PROFILE_SCOPE(nest.profiler, ProfilePhase::kQueueErase);
+    const Order anchor = nest.queue(tier).Remove(nest.anchor);
+    nest.anchor = kInvalidOrderHandle;
+    return anchor;
+}
+
+// The most urgent of the tier's candidate anchors whose flight should not be held, or kInvalidOrderHandle if every
+// one of them should.
+OrderHandle LookaheadPolicy::FindAnchor(NestContext &nest, const Order::Priority tier,
+                                        const Timestamp current_time) const
+{
+    std::array<OrderHandle, kMaxAnchorCandidates> candidates;
+    const size_t num_candidates = nest.queue(tier).MostUrgent(candidates);
+    for (size_t i = 0; i < num_candidates; ++i)
+    {
+        if (!ShouldHold(nest, tier, candidates[i], current_time)) return candidates[i];
+    }
+    return kInvalidOrderHandle;
+}
+
+/*
+    Description: Weighs launching a flight around anchor now against holding it for n ticks. Holding costs every
+                 order already on the flight n ticks of waiting, at the tier's wait cost. Each order that arrives
+                 meanwhile for a hospital near the anchor and still fits saves the flight it would otherwise need,
+                 worth the anchor's round trip in zip time at the configured zip speed. Zip time only buys faster
+                 deliveries while no zip is free, so the saving is scaled by that chance, taken as the fleet's busy
+                 share to the power of its size as if zips were busy independently. Arrivals are Poisson at the
+                 summed rates of the anchor's max_neighbors nearest hospitals that a zip could add to its loop. The
+                 expected number of orders joining grows more slowly than the waiting, so if holding one tick does not
+                 pay off no longer hold does either; holding on is decided again at the next tick.
+    Arguments:
+        - nest: nest the flight would leave from
+        - tier: tier of the anchor
+        - anchor: handle of the order the flight would be built around, in the tier's queue
+        - current_time: time of the tick being planned
+    Returns: True if holding until the next tick, within the tier's max hold, has a positive expected gain.
+*/
+bool LookaheadPolicy::ShouldHold(NestContext &nest, const Order::Priority tier, const OrderHandle anchor_handle,
+                                 const Timestamp current_time) const
+{
+    const LookaheadConfig &lookahead = nest.config.lookahead;
+    const OrderQueue &orders = nest.queue(tier);
+    const Timestamp step = nest.config.time_between_launches;
+    const Timestamp hold_until = orders.deadline(anchor_handle) + lookahead.max_hold[static_cast<size_t>(tier)];
+    if (current_time + step > hold_until) return false;
+
+    // pending orders near the anchor (a lower bound: one per tier with orders at a hospital) and the rate of new ones
+    const HospitalId anchor = orders.at(anchor_handle).hospital_id();
+    const int anchor_dist = nest.hospitals.Distance(nest.node, anchor);
+    const auto &neighbors = nest.hospitals.NeighborsByDistance(anchor);
+    const size_t num_neighbors = std::min(neighbors.size(), lookahead.max_neighbors);
+    size_t num_pending = 0;
+    double rate = 0.0;
+    for (size_t i = 0; i < num_neighbors; ++i)
+    {
+        const HospitalId hospital = neighbors[i];
+        const int loop = anchor_dist + nest.hospitals.Distance(anchor, hospital) +
+                         nest.hospitals.Distance(hospital, nest.node);
+        if (loop >= nest.config.max_range) continue;
+        for (const auto priority : Order::kPrioritiesByUrgency)
+        {
+            num_pending += nest.queue(priority).HasOrdersFor(hospital);
+        }
+        rate += nest.arrival_rates.Rate(hospital, current_time);
+    }
+
+    const int num_stops = static_cast<int>(std::clamp<size_t>(num_pending, 1, nest.config.max_packages));
+    const int num_spare = nest.config.max_packages - num_stops;
+    if (num_spare == 0 || rate <= 0.0) return false;
+
+    const double busy_share = 1.0 - static_cast<double>(nest.fleet.num_free()) / nest.fleet.size();
+    const double fleet_short = std::pow(busy_share, static_cast<double>(nest.fleet.size()));
+    // the leg tables' flight times are baked at load time, so use the configured speed
+    const double saved_per_order = fleet_short * 2.0 * anchor_dist / nest.config.zip_speed;
+    const double wait_cost = lookahead.wait_cost[static_cast<size_t>(tier)] * num_stops * step;
+    return ExpectedArrivalsUpTo(rate * step, num_spare) * saved_per_order > wait_cost;
+}
+
+}  // namespace zipline
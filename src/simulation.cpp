@@ -0,0 +1,153 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "simulation.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace zipline
+{
+Timestamp Simulation::AlignToLaunchGrid(const Timestamp time) const
+{
+    const Timestamp remainder = time % time_between_launches_;
+    return remainder == 0 ? time : time + time_between_launches_ - remainder;
+}
+
+size_t Simulation::Run(const std::vector<Order> &orders, const Timestamp end_time)
+{
+    size_t order_idx = 0;
+    return Run(
+        [&orders, &order_idx]() -> std::optional<Order> {
+            if (order_idx == orders.size()) return std::nullopt;
+            return orders[order_idx++];
+        },
+        end_time);
+}
+
+size_t Simulation::Run(OrderReader &orders, const Timestamp end_time)
+{
+    return Run([&orders]() { return orders.Next(); }, end_time);
+}
+
+std::optional<Timestamp> Simulation::NextLaunchTime(const Timestamp cur_time,
+                                                    const std::optional<Order> &pending_order) const
+{
+    Timestamp next_time = cur_time + time_between_launches_;
+    if (!scheduler_.HasPendingOrders())
+    {
+        if (!pending_order) return std::nullopt;  // everything has been delivered
+        return std::max(next_time, AlignToLaunchGrid(pending_order->received_time()));
+    }
+    // the next order may go to a nest whose zips are idle, so never sleep past the time its nest could launch it
+    // waiting for another nest's zip
+    Timestamp wake_time = scheduler_.NextZipReturnTime();
+    if (pending_order)
+    {
+        const Timestamp launchable_time =
+            std::max(pending_order->received_time(), scheduler_.NextZipReturnTime(*pending_order));
+        wake_time = std::min(wake_time, launchable_time);
+    }
+    return std::max(next_time, AlignToLaunchGrid(wake_time));
+}
+
+size_t Simulation::Run(const OrderSource &next_order, const Timestamp end_time)
+{
+    std::optional<Order> pending_order = next_order();
+    if (!pending_order) return 0;
+
+    const Timestamp start_time = AlignToLaunchGrid(pending_order->received_time());
+    return RunFrom(next_order, pending_order, start_time, 0, end_time);
+}
+
+size_t Simulation::Resume(const std::filesystem::path &checkpoint, const OrderSource &next_order,
+                          const Timestamp end_time)
+{
+    return ResumeFrom(LoadCheckpoint(checkpoint), next_order, end_time);
+}
+
+size_t Simulation::Resume(const std::filesystem::path &checkpoint, OrderReader &orders, const Timestamp end_time)
+{
+    const CheckpointInfo info = LoadCheckpoint(checkpoint);
+    if (!orders.Skip(info.num_orders)) throw CheckpointError("Order log is shorter than the checkpoint");
+    return ResumeFrom(info, [&orders]() { return orders.Next(); }, end_time);
+}
+
+size_t Simulation::ResumeFrom(const CheckpointInfo &info, const OrderSource &next_order, const Timestamp end_time)
+{
+    // pick up exactly where the original run would have gone after the checkpointed tick
+    std::optional<Order> pending_order = next_order();
+    const std::optional<Timestamp> start_time = NextLaunchTime(info.time, pending_order);
+    if (!start_time) return 0;
+    return RunFrom(next_order, pending_order, *start_time, info.num_orders, end_time);
+}
+
+CheckpointInfo Simulation::LoadCheckpoint(const std::filesystem::path &checkpoint)
+{
+    std::ifstream stream{checkpoint, std::ios::binary};
+    if (!stream) throw CheckpointError("Cannot open checkpoint " + checkpoint.string());
+    return scheduler_.LoadCheckpoint(stream);
+}
+
+void Simulation::SaveCheckpoint(const CheckpointInfo &info) const
+{
+    std::filesystem::path temp_path = checkpoint_path_;
+    temp_path += ".tmp";
+    {
+        std::ofstream stream{temp_path, std::ios::binary | std::ios::trunc};
+        scheduler_.SaveCheckpoint(stream, info);
+        if (!stream.flush()) throw CheckpointError("Cannot write checkpoint " + temp_path.string());
+    }
+    std::filesystem::rename(temp_path, checkpoint_path_);
+}
+
+/*
+    Description: Replays orders through the scheduler, only visiting the launch ticks at which something can happen.
+                 Orders are queued at the first tick at or after their received time, exactly as a per-second loop
+                 would do, so the flights produced are identical while the cost is proportional to the number of
+                 events rather than the number of seconds in the horizon.
+    Arguments:
+        - next_order: source of orders sorted by received time
+        - pending_order: the next order, already read from next_order
+        - cur_time: first launch tick to visit
+        - num_orders: orders queued before this call, counted into checkpoints
+        - end_time: first timestamp past the end of the simulated horizon
+    Returns: Number of LaunchFlights calls made.
+*/
+size_t Simulation::RunFrom(const OrderSource &next_order, std::optional<Order> pending_order, Timestamp cur_time,
+                           uint64_t num_orders, const Timestamp end_time)
+{
+    size_t num_ticks = 0;
+    while (cur_time < end_time)
+    {
+        while (pending_order && pending_order->received_time() <= cur_time)
+        {
+            scheduler_.QueueOrder(*pending_order);
+            num_orders++;
+            pending_order = next_order();
+        }
+
+        if (scheduler_.HasPendingOrders())
+        {
+            scheduler_.LaunchFlights(cur_time, flights_);
+            num_ticks++;
+            if (delivery_stats_)
+            {
+                for (const auto &flight : flights_) delivery_stats_->Record(flight);
+            }
+            if (launch_callback_) launch_callback_(cur_time, flights_);
+            if (checkpoint_interval_ > 0 && num_ticks % checkpoint_interval_ == 0)
+            {
+                SaveCheckpoint(CheckpointInfo{cur_time, num_orders});
+            }
+        }
+
+        // skip ahead to the next tick at which the scheduler could launch something
+        const std::optional<Timestamp> next_time = NextLaunchTime(cur_time, pending_order);
+        if (!next_time) break;
+        cur_time = *next_time;
+    }
+
+    return num_ticks;
+}
+
+}  // namespace zipline
@@ -0,0 +1,208 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "streaming.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+#include "csv_reader.h"
+
+namespace zipline
+{
+Timestamp StreamClock::Now() const
+{
+    const std::chrono::duration<double> elapsed = WallClock::now() - wall_start_;
+    return start_time_ + static_cast<Timestamp>(std::floor(elapsed.count() * speedup_));
+}
+
+StreamClock::WallClock::time_point StreamClock::WallTime(const Timestamp time) const
+{
+    const std::chrono::duration<double> offset{(static_cast<double>(time) - start_time_) / speedup_};
+    return wall_start_ + std::chrono::duration_cast<WallClock::duration>(offset);
+}
+
+StreamingDriver::StreamingDriver(ZipScheduler &scheduler, const HospitalTable &hospitals,
+                                 const Timestamp time_between_launches, const StreamingOptions &options)
+    : scheduler_(scheduler),
+      hospitals_(hospitals),
+      time_between_launches_(time_between_launches),
+      options_(options),
+      clock_(options.speedup),
+      channel_(options.queue_capacity)
+{
+    if (!(options.speedup > 0)) throw std::invalid_argument("Streaming speedup must be positive");
+}
+
+Timestamp StreamingDriver::AlignToLaunchGrid(const Timestamp time) const
+{
+    const Timestamp remainder = time % time_between_launches_;
+    return remainder == 0 ? time : time + time_between_launches_ - remainder;
+}
+
+/*
+    Description: Parses one feed line in orders.csv format.
+    Arguments:
+        - line: the line, without its newline
+        - source: name of the feed, for error messages
+        - line_number: 1-based line number within the feed
+        - last_timestamp: received time of the previous accepted order
+    Returns: The order, or nullopt for a blank line. Throws ParseError for a malformed or out-of-order line.
+*/
+std::optional<Order> StreamingDriver::ParseOrder(std::string_view line, const std::string &source,
+                                                 const size_t line_number, const Timestamp last_timestamp) const
+{
+    std::string_view fields[3];
+    const size_t num_fields = SplitInputLine(line, fields, 3);
+    if (num_fields == 1 && fields[0].empty()) return std::nullopt;
+    if (num_fields != 3) throw ParseError(source, line_number, "Got wrong number of order elements (expected 3)");
+
+    Timestamp timestamp = 0;
+    const auto [end, error] = std::from_chars(fields[0].data(), fields[0].data() + fields[0].size(), timestamp);
+    if (error != std::errc{} || end != fields[0].data() + fields[0].size() || fields[0].empty())
+    {
+        throw ParseError(source, line_number, "Invalid received time '" + std::string(fields[0]) + "'");
+    }
+    if (timestamp < last_timestamp) throw ParseError(source, line_number, "Found order timestamps in decreasing order");
+
+    const auto hospital_id = hospitals_.Find(fields[1]);
+    if (!hospital_id) throw ParseError(source, line_number, "Unknown hospital '" + std::string(fields[1]) + "'");
+
+    const auto priority = Order::StringToPriority(fields[2]);
+    if (priority == Order::Priority::kUnknown)
+    {
+        throw ParseError(source, line_number, "Unknown priority '" + std::string(fields[2]) + "'");
+    }
+    return Order{timestamp, *hospital_id, priority};
+}
+
+// Runs on the reader thread until the feed ends or the channel is closed, blocking whenever the planner falls behind.
+void StreamingDriver::ReadOrders(std::istream &input, const std::string &source)
+{
+    std::string line;
+    size_t line_number = 0;
+    Timestamp last_timestamp = std::numeric_limits<Timestamp>::min();
+    while (std::getline(input, line))
+    {
+        line_number++;
+        std::optional<Order> order;
+        try
+        {
+            order = ParseOrder(line, source, line_number, last_timestamp);
+        }
+        catch (const ParseError &error)
+        {
+            std::cerr << error.what() << std::endl;
+            num_rejected_lines_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (!order) continue;
+        last_timestamp = order->received_time();
+        if (!channel_.Push(*order)) break;
+    }
+    channel_.Close();
+}
+
+// Queues the held orders the clock has reached. Returns true if any of them is an emergency.
+bool StreamingDriver::QueueDueOrders(const Timestamp now)
+{
+    bool emergency = false;
+    while (!early_orders_.empty() && early_orders_.front().received_time() <= now)
+    {
+        const Order &order = early_orders_.front();
+        emergency |= order.priority() == Order::Priority::kEmergency;
+        scheduler_.QueueOrder(order);
+        early_orders_.pop_front();
+    }
+    return emergency;
+}
+
+// True if a zip has come back to a nest with orders waiting since the last launch.
+bool StreamingDriver::ZipReturned(const Timestamp now) const
+{
+    const Timestamp return_time = scheduler_.NextZipReturnTime();
+    return return_time <= now && (!last_launch_time_ || return_time > *last_launch_time_);
+}
+
+void StreamingDriver::Launch(const Timestamp now, const LaunchTrigger trigger)
+{
+    scheduler_.LaunchFlights(now, flights_);
+    last_launch_time_ = now;
+    num_launches_[static_cast<size_t>(trigger)]++;
+    if (delivery_stats_)
+    {
+        for (const auto &flight : flights_) delivery_stats_->Record(flight);
+    }
+    if (launch_callback_) launch_callback_(now, flights_);
+}
+
+/*
+    Description: Plans orders as they stream in. Between events the planner sleeps on the channel until the earliest
+                 of the next grid tick, the next zip return and the received time of any order stamped ahead of the
+                 clock, so it is idle while nothing can change and wakes the moment an order arrives.
+    Arguments:
+        - input: feed of orders in orders.csv format, in non-decreasing received time
+        - source: name of the feed, for error messages
+    Returns: Number of LaunchFlights calls made.
+*/
+size_t StreamingDriver::Run(std::istream &input, const std::string &source)
+{
+    std::thread reader{[this, &input, &source] { ReadOrders(input, source); }};
+    try
+    {
+        // the clock starts with the first order; a feed that ends before it has nothing to plan
+        std::vector<Order> arrived;
+        bool open = channel_.PopAll(arrived);
+        if (open) clock_.Start(options_.start_time.value_or(arrived.front().received_time()));
+        Timestamp next_tick = open ? AlignToLaunchGrid(clock_.Now()) : 0;
+        while (open || !early_orders_.empty() || scheduler_.HasPendingOrders())
+        {
+            num_orders_ += arrived.size();
+            early_orders_.insert(early_orders_.end(), arrived.begin(), arrived.end());
+            arrived.clear();
+
+            const Timestamp now = clock_.Now();
+            const bool emergency = QueueDueOrders(now);
+            if (scheduler_.HasPendingOrders())
+            {
+                if (emergency) Launch(now, LaunchTrigger::kEmergency);
+                else if (ZipReturned(now)) Launch(now, LaunchTrigger::kZipReturn);
+                else if (now >= next_tick) Launch(now, LaunchTrigger::kGrid);
+            }
+            if (now >= next_tick) next_tick = AlignToLaunchGrid(now + 1);
+
+            Timestamp wake_time = next_tick;
+            if (!early_orders_.empty()) wake_time = std::min(wake_time, early_orders_.front().received_time());
+            if (scheduler_.HasPendingOrders())
+            {
+                const Timestamp return_time = scheduler_.NextZipReturnTime();
+                if (!last_launch_time_ || return_time > *last_launch_time_)
+                {
+                    wake_time = std::min(wake_time, return_time);
+                }
+            }
+            // orders stamped ahead of the clock count against the channel's capacity, so a feed running ahead of
+            // the clock blocks in the reader instead of piling up here
+            const size_t room = channel_.capacity() - std::min(early_orders_.size(), channel_.capacity());
+            if (open && room > 0) open = channel_.PopAllUntil(arrived, clock_.WallTime(wake_time), room);
+            else std::this_thread::sleep_until(clock_.WallTime(wake_time));
+        }
+    }
+    catch (...)
+    {
+        // the reader stops at its next line once the channel is closed
+        channel_.Close();
+        reader.join();
+        throw;
+    }
+    reader.join();
+
+    size_t num_ticks = 0;
+    for (const size_t count : num_launches_) num_ticks += count;
+    return num_ticks;
+}
+
+}  // namespace zipline
@@ -0,0 +1,83 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "thread_pool.h"
+
+namespace zipline
+{
+ThreadPool::ThreadPool(const size_t num_workers)
+{
+    workers_.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) workers_.emplace_back([this] { WorkerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto &worker : workers_) worker.join();
+}
+
+void ThreadPool::RunTasks(const std::function<void(size_t)> &task, const size_t count)
+{
+    for (size_t i = next_index_.fetch_add(1); i < count; i = next_index_.fetch_add(1)) task(i);
+}
+
+void ThreadPool::ParallelFor(const size_t count, const std::function<void(size_t)> &task)
+{
+    if (workers_.empty() || count <= 1)
+    {
+        for (size_t i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> loop_lock(loop_mutex_);
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // stragglers from the previous loop must be gone before its state is reset
+        done_cv_.wait(lock, [this] { return active_workers_ == 0; });
+        task_ = &task;
+        count_ = count;
+        next_index_ = 0;
+        generation_++;
+    }
+    work_cv_.notify_all();
+
+    RunTasks(task, count);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return active_workers_ == 0; });
+    task_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    uint64_t seen_generation = 0;
+    while (true)
+    {
+        const std::function<void(size_t)> *task = nullptr;
+        size_t count = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [this, seen_generation] { return stopping_ || generation_ != seen_generation; });
+            if (stopping_) return;
+            seen_generation = generation_;
+            if (!task_) continue;  // woke up after the loop already finished
+            task = task_;
+            count = count_;
+            active_workers_++;
+        }
+
+        RunTasks(*task, count);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_workers_--;
+        }
+        done_cv_.notify_all();
+    }
+}
+
+}  // namespace zipline
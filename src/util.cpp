@@ -6,11 +6,11 @@ namespace zipline
 {
 namespace
 {
-std::string trim(const std::string &str)
+std::string_view trim(std::string_view str)
 {
-    const std::string whitespace = " \t\n";
+    constexpr std::string_view whitespace = " \t\r\n";
     const auto start = str.find_first_not_of(whitespace);
-    if (start == std::string::npos)
+    if (start == std::string_view::npos)
     {
         return {};
     }
@@ -20,21 +20,20 @@ std::string trim(const std::string &str)
 }
 }  // namespace
 
-std::vector<std::string> ParseInputLine(const std::string &line)
+size_t SplitInputLine(std::string_view line, std::string_view *fields, const size_t max_fields)
 {
-    size_t pos{0};
-    size_t last_pos{0};
-    std::vector<std::string> tokens{};
-    std::string delim = ", ";
-    while ((pos = line.substr(last_pos, line.size()).find(delim)) != std::string::npos)
+    size_t num_fields = 0;
+    size_t start = 0;
+    while (true)
     {
-        auto token = trim(line.substr(last_pos, pos));
-        tokens.emplace_back(token);
-        last_pos += pos + delim.size();
+        const size_t pos = line.find(',', start);
+        const std::string_view field = trim(line.substr(start, pos == std::string_view::npos ? pos : pos - start));
+        if (num_fields < max_fields) fields[num_fields] = field;
+        num_fields++;
+        if (pos == std::string_view::npos) break;
+        start = pos + 1;
     }
-
-    tokens.emplace_back(trim(line.substr(line.find_last_of(delim), line.size())));
-    return tokens;
+    return num_fields;
 }
 
 }  // namespace zipline
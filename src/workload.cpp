@@ -0,0 +1,87 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+#include "workload.h"
+
+#include <cmath>
+#include <numbers>
+#include <string>
+
+namespace
+{
+// Keeps the order stream independent of the hospital layout generated from the same seed.
+constexpr uint64_t kOrderStreamSalt = 0x9E3779B97F4A7C15;
+}  // namespace
+
+namespace zipline
+{
+HospitalTable GenerateHospitals(const WorkloadConfig &config, const int zip_speed)
+{
+    std::mt19937_64 rng{config.seed};
+    std::uniform_real_distribution<double> unit{0.0, 1.0};
+
+    HospitalTable hospitals;
+    for (size_t i = 0; i < config.num_hospitals; ++i)
+    {
+        // sqrt keeps the density uniform over the disk instead of bunching hospitals near the nest
+        const double r = config.radius * std::sqrt(unit(rng));
+        const double theta = 2.0 * std::numbers::pi * unit(rng);
+        hospitals.Add("Hospital " + std::to_string(i + 1), static_cast<int>(r * std::cos(theta)),
+                      static_cast<int>(r * std::sin(theta)));
+    }
+    hospitals.BuildLegTables(zip_speed);
+    return hospitals;
+}
+
+OrderGenerator::OrderGenerator(const WorkloadConfig &config, const HospitalTable &hospitals)
+    : config_(config),
+      hospitals_(hospitals),
+      rng_(config.seed ^ kOrderStreamSalt),
+      current_time_(config.start_time)
+{
+    // pick the calm rate so that the time-weighted average of the calm and burst rates is orders_per_hour
+    const double rate = config.orders_per_hour / 3600.0;
+    if (config.arrivals == ArrivalPattern::kBursty)
+    {
+        calm_rate_ = rate / (1.0 - config.burst_fraction + config.burst_fraction * config.burst_rate_factor);
+        state_end_time_ = current_time_ + NextStateLength();
+    }
+    else
+    {
+        calm_rate_ = rate;
+        state_end_time_ = INFINITY;
+    }
+}
+
+// Burst and calm periods both last an exponentially distributed time, sized so bursts cover burst_fraction overall.
+double OrderGenerator::NextStateLength()
+{
+    const double mean_burst = config_.mean_burst_length;
+    const double mean_calm = mean_burst * (1.0 - config_.burst_fraction) / config_.burst_fraction;
+    return std::exponential_distribution<double>{1.0 / (in_burst_ ? mean_burst : mean_calm)}(rng_);
+}
+
+Order OrderGenerator::Next()
+{
+    // the process is memoryless, so when a state change comes before the next arrival the wait simply restarts from
+    // the state change at the new rate
+    for (;;)
+    {
+        const double rate = in_burst_ ? calm_rate_ * config_.burst_rate_factor : calm_rate_;
+        const double arrival = current_time_ + std::exponential_distribution<double>{rate}(rng_);
+        if (arrival < state_end_time_)
+        {
+            current_time_ = arrival;
+            break;
+        }
+        current_time_ = state_end_time_;
+        in_burst_ = !in_burst_;
+        state_end_time_ = current_time_ + NextStateLength();
+    }
+
+    const auto hospital = std::uniform_int_distribution<size_t>{0, hospitals_.size() - 1}(rng_);
+    const bool emergency = std::bernoulli_distribution{config_.emergency_fraction}(rng_);
+    return Order(static_cast<Timestamp>(current_time_), static_cast<HospitalId>(hospital),
+                 emergency ? Order::Priority::kEmergency : Order::Priority::kResupply);
+}
+
+}  // namespace zipline
@@ -2,244 +2,468 @@
 
 #include "zip_scheduler.h"
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
 namespace zipline
 {
 
+ZipScheduler::ZipScheduler(const HospitalTable &hospitals, const SchedulerConfig &config)
+    : hospitals_(hospitals), config_(config), intake_(config.intake_capacity)
+{
+    config_.Validate();
+    for (size_t i = 0; i < hospitals_.num_nests(); ++i)
+    {
+        nests_.emplace_back(i, hospitals_, config_);
+    }
+    if (nests_.size() > 1)
+    {
+        const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+        thread_pool_ = std::make_unique<ThreadPool>(std::min(nests_.size(), static_cast<size_t>(num_threads)) - 1);
+    }
+    if (config_.batch_planning.max_moves > 0)
+    {
+        batch_planner_ = std::make_unique<BatchPlanner>(hospitals_, config_);
+        // with several nests the nests themselves are planned in parallel, so moves are evaluated inline
+        if (nests_.size() == 1)
+        {
+            const size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+            batch_thread_pool_ = std::make_unique<ThreadPool>(num_threads - 1);
+            batch_planner_->set_thread_pool(batch_thread_pool_.get());
+        }
+    }
+    InitializeZips(config_.num_zips);
+}
+
 void ZipScheduler::InitializeZips(const int num_zips)
 {
-    for (int i = 0; i < num_zips; ++i) zip_return_times_.push_back(0);
+    InitializeZips(std::vector<int>(nests_.size(), num_zips));
+}
+
+void ZipScheduler::InitializeZips(const std::vector<int> &zips_per_nest)
+{
+    assert(zips_per_nest.size() == nests_.size() && "Need a zip count for every nest");
+    for (size_t i = 0; i < nests_.size(); ++i)
+    {
+        nests_[i].fleet.Initialize(zips_per_nest[i], config_.num_zips_reduced_range);
+        nests_[i].planned_flights.reserve(zips_per_nest[i]);
+        nests_[i].flights.reserve(zips_per_nest[i]);
+        nests_[i].stop_buffers.reserve(zips_per_nest[i]);
+        nests_[i].leftovers.reserve(Order::kNumPriorities * BatchPlanner::kMaxLeftoversPerTier);
+    }
 }
 
-void ZipScheduler::QueueOrder(const Order &order)
+OrderId ZipScheduler::QueueOrder(const Order &order)
 {
-    std::cout << "Queuing order:\n\t" << order.received_time() << "\n\t" << order.hospital().name() << "\n\t"
-              << Order::PriorityToString(order.priority()) << std::endl;
+    const IntakeOrder intake_order{order, next_order_id_.fetch_add(1, std::memory_order_relaxed)};
+    // count the order first so the launching thread never sees it as neither pending nor queued
+    num_intake_orders_.fetch_add(1, std::memory_order_relaxed);
+    if (!intake_overflowing_.load(std::memory_order_acquire) && intake_.TryPush(intake_order)) return intake_order.id;
+
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    overflow_orders_.push_back(intake_order);
+    intake_overflowing_.store(true, std::memory_order_release);
+    return intake_order.id;
+}
 
-    std::shared_ptr<Order> order_ptr = std::make_shared<Order>(order);
-    if (order.priority() == Order::Priority::kEmergency)
+// Moves every order queued since the last tick into the queue of the nest that will serve it. Returns the number of
+// orders moved.
+size_t ZipScheduler::DrainIntake()
+{
+    size_t num_drained = 0;
+    IntakeOrder intake_order;
+    while (intake_.TryPop(intake_order))
     {
-        emergency_orders_.push_back(order_ptr);
+        AddToNest(intake_order);
+        num_drained++;
     }
-    else
+
+    if (intake_overflowing_.load(std::memory_order_acquire))
     {
-        resupply_orders_.push_back(order_ptr);
+        std::vector<IntakeOrder> overflow_orders;
+        {
+            std::lock_guard<std::mutex> lock(overflow_mutex_);
+            overflow_orders.swap(overflow_orders_);
+            intake_overflowing_.store(false, std::memory_order_release);
+        }
+        for (const auto &overflow_order : overflow_orders) AddToNest(overflow_order);
+        num_drained += overflow_orders.size();
     }
+
+    num_intake_orders_.fetch_sub(num_drained, std::memory_order_relaxed);
+    return num_drained;
 }
 
-std::vector<Flight> ZipScheduler::LaunchFlights(Timestamp current_time)
+// The order's id doubles as its sequence number in the queue, so equal deadlines still tie in arrival order.
+void ZipScheduler::AddToNest(const IntakeOrder &intake_order)
 {
-    std::cout << "Asking for flights at " << current_time << std::endl;
-    std::vector<Flight> flights;
-    // compute the number of available zips
-    std::vector<int> free_zip_indexes = GetFreeZips(current_time);
+    const Order &order = intake_order.order;
+    NestState &nest = nests_[AssignNest(order)];
+    ZIP_LOG_EVENT(event_log_, LogLevel::kDebug, LogEvent::OrderQueued(order, nest.nest_idx));
+    nest.arrival_rates.Record(order.hospital_id(), order.received_time());
+    const OrderHandle handle = nest.queue(order.priority()).Push(order, intake_order.id);
+    order_index_.Insert(intake_order.id, OrderLocation{static_cast<uint32_t>(nest.nest_idx), order.priority(), handle});
+    if (order_index_.size() > order_index_purge_size_) PurgeOrderIndex();
+}
+
+// Drops the index entries of orders that have since launched. Called once the index has doubled since the last purge,
+// so the cost is amortized over the orders that grew it.
+void ZipScheduler::PurgeOrderIndex()
+{
+    order_index_.EraseIf([this](const OrderId id, const OrderLocation &location) {
+        return !nests_[location.nest_idx].queue(location.priority).Holds(location.handle, id);
+    });
+    order_index_purge_size_ = std::max(kMinOrderIndexPurgeSize, 2 * order_index_.size());
+}
 
-    if (!free_zip_indexes.empty())
+void ZipScheduler::RebuildOrderIndex()
+{
+    order_index_.Clear();
+    for (const auto &nest : nests_)
     {
-        size_t zip_idx_itr = 0;
-        // prioritize emergency orders
-        while (!emergency_orders_.empty() && zip_idx_itr < free_zip_indexes.size())
-        {
-            ScheduleFlights(free_zip_indexes[zip_idx_itr], flights, kMaxRange, current_time);
-            zip_idx_itr++;
-        }
-        if (zip_idx_itr < free_zip_indexes.size())
+        for (const auto priority : Order::kPrioritiesByUrgency)
         {
-            // deploy only one zip at a time for just resupply orders
-            // wait until 5 resupply orders in queue or 15 min, whichever comes first
-            if (resupply_orders_.size() >= kMinResupplyOrders ||
-                (!resupply_orders_.empty() &&
-                 resupply_orders_.front()->received_time() + kMaxResupplyWaitTime <= current_time))
+            const OrderQueue &queue = nest.queue(priority);
+            for (const OrderHandle handle : queue.handles())
             {
-                std::unordered_set<size_t> zip_idx_reduced_range;  // indices 8, 9
-                for (size_t i = zip_return_times_.size() - 1; i >= zip_return_times_.size() - kNumZipsReducedRange; --i)
-                {
-                    zip_idx_reduced_range.insert(i);
-                }
-
-                size_t zip_idx = free_zip_indexes[zip_idx_itr];
-                // if zip 8 or 9, keep flight to 45 min round trip to have them back sooner for any incoming emergencies
-                if (zip_idx_reduced_range.find(zip_idx) != zip_idx_reduced_range.end())
-                {
-                    ScheduleFlights(zip_idx, flights, kRangeReducedRange, current_time);
-                }
-                else  // other zips can use the max range
-                {
-                    ScheduleFlights(zip_idx, flights, kMaxRange, current_time);
-                }
+                order_index_.Insert(queue.sequence(handle),
+                                    OrderLocation{static_cast<uint32_t>(nest.nest_idx), priority, handle});
             }
         }
     }
+    order_index_purge_size_ = std::max(kMinOrderIndexPurgeSize, 2 * order_index_.size());
+}
 
-    // print flights
-    for (size_t i = 0; i < flights.size(); ++i)
+/*
+    Description: Looks up a pending order by id, dropping its index entry if it has launched since.
+    Arguments:
+        - id: id returned by QueueOrder
+        - location: set to the order's index entry when found
+    Returns: The queue holding the order, or nullptr if it is no longer pending. Called with state_mutex_ held and
+             the intake drained.
+*/
+OrderQueue *ZipScheduler::FindPendingOrder(const OrderId id, OrderLocation *&location)
+{
+    OrderLocation *found = order_index_.Find(id);
+    if (!found) return nullptr;
+    OrderQueue &queue = nests_[found->nest_idx].queue(found->priority);
+    if (!queue.Holds(found->handle, id))
     {
-        std::cout << "Flight " << i + 1 << std::endl;
-        for (Order order : flights[i].orders())
-        {
-            std::cout << "Executing order:\n\t" << order.received_time() << "\n\t" << order.hospital().name() << "\n\t"
-                      << Order::PriorityToString(order.priority()) << std::endl
-                      << std::endl;
-        }
+        order_index_.Erase(id);
+        return nullptr;
     }
+    location = found;
+    return &queue;
+}
 
-    std::cout << "Number of available zips: " << free_zip_indexes.size() << std::endl;
-    std::cout << "Number of zips taking off: " << flights.size() << std::endl;
-    assert(free_zip_indexes.size() >= flights.size());
-    std::cout << "Number of emergency orders remaining: " << emergency_orders_.size() << std::endl;
-    std::cout << "Number of resupply orders remaining: " << resupply_orders_.size() << std::endl;
-    std::cout << "-----------------------------------------------------------" << std::endl;
+bool ZipScheduler::CancelOrder(const OrderId id)
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    DrainIntake();
+    OrderLocation *location = nullptr;
+    OrderQueue *queue = FindPendingOrder(id, location);
+    if (!queue) return false;
 
-    return flights;
+    queue->Remove(location->handle);
+    order_index_.Erase(id);
+    return true;
 }
 
-// Helper functions
-// Returns the indices (0-9) of zips available to deliver orders by checking
-// the zips' return time against the current time.
-std::vector<int> ZipScheduler::GetFreeZips(const Timestamp curr_time)
+bool ZipScheduler::ChangePriority(const OrderId id, const Order::Priority priority)
 {
-    std::vector<int> zip_indexes;
-
-    for (size_t i = 0; i < zip_return_times_.size(); ++i)
+    if (priority == Order::Priority::kUnknown || static_cast<size_t>(priority) >= Order::kNumPriorities)
     {
-        if (zip_return_times_[i] <= curr_time) zip_indexes.push_back(i);
+        throw std::invalid_argument("Cannot move an order to priority " + Order::PriorityToString(priority));
     }
-    return zip_indexes;
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    DrainIntake();
+    OrderLocation *location = nullptr;
+    OrderQueue *queue = FindPendingOrder(id, location);
+    if (!queue) return false;
+    if (location->priority == priority) return true;
+
+    NestState &nest = nests_[location->nest_idx];
+    const Order order = queue->Remove(location->handle);
+    const Order moved{order.received_time(), order.hospital_id(), priority};
+    location->handle = nest.queue(priority).Push(moved, id);
+    location->priority = priority;
+    return true;
+}
+
+bool ZipScheduler::ChangeDeadline(const OrderId id, const Timestamp deadline)
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    DrainIntake();
+    OrderLocation *location = nullptr;
+    OrderQueue *queue = FindPendingOrder(id, location);
+    if (!queue) return false;
+
+    queue->SetDeadline(location->handle, deadline);
+    return true;
 }
 
 /*
-    Description: Performs order scheduling for a zip by maximizing the amount of packages it can deliver
-                 within its maximum range. After adding the first emergency or resupply order (based on
-                 received time), it searches through other orders (prioritizing emergency ones) and adding
-                 those closest to the current order location.
+    Description: Picks the nest that will serve an order, trading off distance against how backed up each nest is.
+                 Nests that cannot fly the round trip at full range are skipped unless none can.
     Arguments:
-        - zip_idx: index of the zip for which the flight is being scheduled for
-        - flights: vector of flights that the computed flight will be appended to
-        - max_range: max distance for the zip (either reduced or max)
-        - curr_time: the launch time for the flight
+        - order: order being queued
+    Returns: Index of the chosen nest.
 */
-void ZipScheduler::ScheduleFlights(const int zip_idx, std::vector<Flight> &flights, const int max_range,
-                                   const int curr_time)
+size_t ZipScheduler::AssignNest(const Order &order) const
+{
+    if (nests_.size() == 1) return 0;
+
+    size_t best_nest = 0;
+    long best_cost = std::numeric_limits<long>::max();
+    bool best_reachable = false;
+    for (const auto &nest : nests_)
+    {
+        const int dist = hospitals_.Distance(nest.node, order.hospital_id());
+        const bool reachable = 2 * dist < config_.max_range;
+        const size_t num_zips = std::max<size_t>(1, nest.fleet.size());
+        const long cost = dist + static_cast<long>(config_.nest_load_penalty * nest.pending_orders() / num_zips);
+        if ((reachable && !best_reachable) || (reachable == best_reachable && cost < best_cost))
+        {
+            best_nest = nest.nest_idx;
+            best_cost = cost;
+            best_reachable = reachable;
+        }
+    }
+    return best_nest;
+}
+
+std::vector<Flight> ZipScheduler::LaunchFlights(const Timestamp current_time)
+{
+    std::vector<Flight> flights;
+    LaunchFlights(current_time, flights);
+    return flights;
+}
+
+void ZipScheduler::LaunchFlights(const Timestamp current_time, std::vector<Flight> &flights)
 {
-    std::vector<Order> orders;
-    int curr_dist(0);
-    int return_dist(0);
-    int curr_x(0);
-    int curr_y(0);
+    ZIP_PROFILE_TICK(profiler_, current_time);
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    {
+        ZIP_PROFILE_SCOPE(profiler_, ProfilePhase::kDrainIntake);
+        const size_t num_drained = DrainIntake();
+        ZIP_PROFILE_COUNT(profiler_, ProfileCounter::kOrdersDrained, num_drained);
+    }
+    ZIP_LOG_EVENT(event_log_, LogLevel::kDebug, LogEvent::TickStarted(current_time));
 
-    // get first order in emergency (priority) or resupply queue
-    if (!emergency_orders_.empty())
+    const auto plan_nest = [this, current_time](size_t i) { PlanNest(nests_[i], current_time); };
+
+    // nests share nothing but the read-only hospital table, so plan them concurrently
+    if (thread_pool_)
     {
-        orders.push_back(*GetFirstOrder(curr_x, curr_y, curr_dist, return_dist, emergency_orders_));
+        thread_pool_->ParallelFor(nests_.size(), plan_nest);
     }
-    else if (!resupply_orders_.empty())
+    else
     {
-        orders.push_back(*GetFirstOrder(curr_x, curr_y, curr_dist, return_dist, resupply_orders_));
+        for (size_t i = 0; i < nests_.size(); ++i) plan_nest(i);
     }
-    else  // no emergency and resupply orders
+
+    // merge in nest order so the result does not depend on thread timing
+    flights.clear();
+    size_t num_free_zips = 0;
+    size_t num_emergency_orders = 0;
+    size_t num_resupply_orders = 0;
+    for (auto &nest : nests_)
     {
-        return;
+        flights.insert(flights.end(), nest.flights.begin(), nest.flights.end());
+        nest.flights.clear();
+        num_free_zips += nest.num_free_zips;
+        num_emergency_orders += nest.queue(Order::Priority::kEmergency).size();
+        num_resupply_orders += nest.queue(Order::Priority::kResupply).size();
+        ZIP_PROFILE_COUNT(profiler_, ProfileCounter::kQueueDepth, nest.pending_orders());
     }
+    ZIP_PROFILE_COUNT(profiler_, ProfileCounter::kFlightsPerTick, flights.size());
 
-    // add any nearby emergency/resupply orders nearby up to range and package capacity
-    while (curr_dist < max_range && orders.size() < kMaxPackages)
+    // report flights
+    for (size_t i = 0; i < flights.size(); ++i)
     {
-        std::shared_ptr<Order> order_ptr = GetNextOrderByDist(curr_x, curr_y, curr_dist, return_dist, max_range);
-        if (order_ptr)
-        {
-            orders.push_back(*order_ptr);
-        }
-        else
+        const Flight &flight = flights[i];
+        ZIP_LOG_EVENT(event_log_, LogLevel::kInfo,
+                      LogEvent::FlightLaunched(current_time, i + 1, flight.nest(), flight.zip(), flight.num_stops()));
+        for (const Order &order : flight.orders())
         {
-            break;
+            ZIP_LOG_EVENT(event_log_, LogLevel::kDebug, LogEvent::StopPlanned(order, i + 1));
         }
     }
-    curr_dist += return_dist;  // compute total distance of orders
-    zip_return_times_[zip_idx] = curr_time + ceil((float)curr_dist / kZipSpeed);
-    flights.push_back(Flight(curr_time, orders));
-}
 
-// Returns the first order in orders and updates the necessary parameters.
-std::shared_ptr<Order> ZipScheduler::GetFirstOrder(int &curr_x, int &curr_y, int &curr_dist, int &return_dist,
-                                                   std::vector<std::shared_ptr<Order>> &orders)
-{
-    std::shared_ptr<Order> order = orders.front();
-    curr_dist = GetDistanceBetweenPoints(curr_x, curr_y, order->hospital().east(), order->hospital().north());
-    return_dist = curr_dist;
-    curr_x = order->hospital().east();
-    curr_y = order->hospital().north();
-    orders.erase(orders.begin());
-    return order;
+    assert(num_free_zips >= flights.size());
+    ZIP_LOG_EVENT(event_log_, LogLevel::kInfo,
+                  LogEvent::TickSummary(current_time, num_free_zips, flights.size(), num_emergency_orders,
+                                        num_resupply_orders));
 }
 
-/*
-    Description: Gets the order location (hospital) that is closest to the current one, ensuring zip can both reach and
-                 return to nest from there. Prioritizes emergency orders before resupply ones.
-    Arguments:
-        - curr_x: east coordinate of the hospital associated with the current order
-        - curr_y: north coordinate of the hospital associated with the current order
-        - curr_dist: running total of the distance to deliver all of the orders
-        - return_dist: distance from the last order location to nest
-        - max_range: max distance for zip
-    Returns: Pointer to the nearest order or nullptr if none is within range.
-*/
-std::shared_ptr<Order> ZipScheduler::GetNextOrderByDist(int &curr_x, int &curr_y, int &curr_dist, int &return_dist,
-                                                        const int max_range)
+// Plans the flights launching from one nest at the current tick into nest.flights.
+void ZipScheduler::PlanNest(NestState &nest, const Timestamp current_time) const
 {
-    std::shared_ptr<Order> min_order_ptr =
-        GetNextOrderInQueue(curr_x, curr_y, curr_dist, return_dist, max_range, emergency_orders_);
-    if (!min_order_ptr)
-        min_order_ptr = GetNextOrderInQueue(curr_x, curr_y, curr_dist, return_dist, max_range, resupply_orders_);
-    return min_order_ptr;
+    ZIP_PROFILE_SCOPE(profiler_, ProfilePhase::kPlanNest);
+    std::visit([&](const auto &policy) { PlanNestWith(policy, nest, current_time); }, policy_);
 }
 
 /*
-    Description: Gets the order location (hospital) that is closest to the current one, ensuring zip can both reach and
-                 return to nest from there.
-    Arguments:
-        - curr_x: east coordinate of the hospital associated with the current order
-        - curr_y: north coordinate of the hospital associated with the current order
-        - curr_dist: running total of the distance to deliver all of the orders
-        - return_dist: distance from the last order location to nest
-        - max_range: max distance for zip
-        - orders: vector of emergency or resupply orders to search through
-    Returns: Pointer to the nearest order or nullptr if none is within range.
+    Description: Plans one nest's tick with a concrete policy, so every policy call below is resolved at compile
+                 time. Tiers are served most urgent first; each keeps starting flights while it has orders, a zip is
+                 free and the policy wants to launch. A flight is built around the policy's anchor order, then
+                 optionally improved together with the tick's other flights before being committed to the fleet.
 */
-std::shared_ptr<Order> ZipScheduler::GetNextOrderInQueue(int &curr_x, int &curr_y, int &curr_dist, int &return_dist,
-                                                         const int max_range,
-                                                         std::vector<std::shared_ptr<Order>> &orders)
+template <typename Policy>
+void ZipScheduler::PlanNestWith(const Policy &policy, NestState &nest, const Timestamp current_time) const
 {
-    if (orders.empty()) return nullptr;  // return null when there are no emergency orders
-    int min_dist(INT_MAX);
-    int min_idx(-1);
+    static_assert(SchedulingPolicy<Policy>);
+    nest.planned_flights.clear();
+
+    // compute the number of available zips
+    {
+        ZIP_PROFILE_SCOPE(profiler_, ProfilePhase::kFreeZips);
+        nest.fleet.ReleaseReturned(current_time);
+        nest.num_free_zips = nest.fleet.num_free();
+    }
+
+    NestContext context{hospitals_, config_, nest.node, nest.queues, nest.fleet, nest.routes, nest.arrival_rates,
+                        profiler_};
+    for (const auto priority : Order::kPrioritiesByUrgency)
+    {
+        for (int num_flights = 0; nest.fleet.HasFree() && !nest.queue(priority).empty() &&
+                                  policy.ShouldLaunch(context, priority, num_flights, current_time);
+             ++num_flights)
+        {
+            const int zip_idx = nest.fleet.TakeLowestFree();
+            const int max_range = policy.FlightRange(context, priority, zip_idx);
+            std::vector<Order> stops;
+            if (!nest.stop_buffers.empty())
+            {
+                stops = std::move(nest.stop_buffers.back());
+                nest.stop_buffers.pop_back();
+            }
+            stops.reserve(config_.max_packages);
+            context.num_scanned = 0;
+            {
+                ZIP_PROFILE_SCOPE(profiler_, ProfilePhase::kPickAnchor);
+                stops.push_back(policy.PickAnchor(context, priority));
+            }
+            int distance = 0;
+            {
+                ZIP_PROFILE_SCOPE(profiler_, ProfilePhase::kBuildRoute);
+                distance = policy.BuildRoute(context, stops, max_range);
+            }
+            ZIP_PROFILE_COUNT(profiler_, ProfileCounter::kCandidatesScanned, context.num_scanned);
+            ZIP_PROFILE_COUNT(profiler_, ProfileCounter::kStopsPerFlight, stops.size());
+            nest.planned_flights.push_back(PlannedFlight{zip_idx, max_range, std::move(stops), distance});
+        }
+    }
 
-    // find idx of next order with the closest hospital to (curr_x, curr_y)
-    for (size_t i = 0; i < orders.size(); ++i)
+    // rebalance stops across every zip leaving this tick, offering them the most urgent orders still waiting
+    if (batch_planner_)
     {
-        Hospital hospital = orders[i]->hospital();
-        int dist_to_next = GetDistanceBetweenPoints(curr_x, curr_y, hospital.east(), hospital.north());
-        if (dist_to_next < min_dist)
+        ZIP_PROFILE_SCOPE(profiler_, ProfilePhase::kBatchPlan);
+        nest.leftovers.clear();
+        for (const auto priority : Order::kPrioritiesByUrgency)
+        {
+            // every tier, even one the policy is holding back: a flight leaving anyway may carry its orders early
+            const OrderQueue &queue = nest.queue(priority);
+            std::array<OrderHandle, BatchPlanner::kMaxLeftoversPerTier> handles;
+            const size_t num_leftovers = queue.MostUrgent(handles);
+            for (size_t i = 0; i < num_leftovers; ++i)
+            {
+                nest.leftovers.push_back(LeftoverOrder{queue.at(handles[i]), handles[i], queue.deadline(handles[i])});
+            }
+        }
+        const Timestamp next_tick = current_time + config_.time_between_launches;
+        const Timestamp next_zip_time =
+            nest.fleet.HasFree() ? next_tick : std::max(next_tick, nest.fleet.NextReturnTime());
+        batch_planner_->Improve(nest.routes, nest.node, current_time, nest.planned_flights, nest.leftovers,
+                                next_zip_time, nest.batch_scratch);
+        for (const auto &leftover : nest.leftovers)
         {
-            min_dist = dist_to_next;  // distance from curr hospital to next
-            min_idx = i;
+            if (leftover.taken) nest.queue(leftover.order.priority()).Remove(leftover.handle);
         }
     }
 
-    std::shared_ptr<Order> min_order = orders[min_idx];
-    int next_x(min_order->hospital().east());
-    int next_y(min_order->hospital().north());
-    // compute distance from hospital of next order to nest
-    int dist_next_to_nest = GetDistanceBetweenPoints(next_x, next_y, 0, 0);
+    ZIP_PROFILE_SCOPE(profiler_, ProfilePhase::kCommit);
+    for (auto &planned : nest.planned_flights)
+    {
+        const Flight &flight = nest.flights.emplace_back(current_time, planned.stops, nest.nest_idx, planned.zip_idx,
+                                                         hospitals_, config_.zip_speed);
+        nest.fleet.Launch(planned.zip_idx, flight.return_time());
+        planned.stops.clear();
+        nest.stop_buffers.push_back(std::move(planned.stops));
+    }
+}
+
+void ZipScheduler::SaveCheckpoint(std::ostream &stream, const CheckpointInfo &info)
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    DrainIntake();
+
+    CheckpointWriter writer{stream};
+    writer.Write(info.time);
+    writer.Write(info.num_orders);
+    writer.Write(next_order_id_.load(std::memory_order_relaxed));
+    writer.Write(static_cast<uint32_t>(hospitals_.size()));
+    writer.Write(static_cast<uint32_t>(nests_.size()));
+    writer.Write(static_cast<uint32_t>(Order::kPrioritiesByUrgency.size()));
+    for (const auto &nest : nests_)
+    {
+        nest.fleet.Save(writer);
+        for (const auto priority : Order::kPrioritiesByUrgency) nest.queue(priority).Save(writer);
+        nest.arrival_rates.Save(writer);
+    }
+}
+
+CheckpointInfo ZipScheduler::LoadCheckpoint(std::istream &stream)
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    CheckpointReader reader{stream};
+    CheckpointInfo info;
+    info.time = reader.Read<Timestamp>();
+    info.num_orders = reader.Read<uint64_t>();
+    const auto next_order_id = reader.Read<OrderId>();
+    reader.Expect(reader.Read<uint32_t>() == hospitals_.size(), "taken with a different set of hospitals");
+    reader.Expect(reader.Read<uint32_t>() == nests_.size(), "taken with a different set of nests");
+    reader.Expect(reader.Read<uint32_t>() == Order::kPrioritiesByUrgency.size(), "taken with other priority tiers");
 
-    // check if zip can make it back home
-    if (curr_dist + min_dist + dist_next_to_nest < max_range)
+    for (auto &nest : nests_)
     {
-        curr_x = next_x;
-        curr_y = next_y;
-        return_dist = dist_next_to_nest;
-        curr_dist += min_dist;
-        orders.erase(orders.begin() + min_idx);
-        return min_order;
+        nest.fleet.Load(reader);
+        for (const auto priority : Order::kPrioritiesByUrgency) nest.queue(priority).Load(reader);
+        nest.arrival_rates.Load(reader);
     }
-    return nullptr;
+    next_order_id_.store(next_order_id, std::memory_order_relaxed);
+    RebuildOrderIndex();
+    return info;
+}
+
+bool ZipScheduler::HasPendingOrders() const
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    if (num_intake_orders_.load(std::memory_order_relaxed) > 0) return true;
+    return std::any_of(nests_.begin(), nests_.end(), [](const NestState &nest) { return nest.pending_orders() > 0; });
 }
-}  // namespace zipline
\ No newline at end of file
+
+Timestamp ZipScheduler::NextZipReturnTime() const
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    // orders still in the intake have no nest yet, so any nest's zips could take them
+    const bool undrained = num_intake_orders_.load(std::memory_order_relaxed) > 0;
+    Timestamp next_time = std::numeric_limits<Timestamp>::max();
+    for (const auto &nest : nests_)
+    {
+        if (undrained || nest.pending_orders() > 0) next_time = std::min(next_time, nest.fleet.NextReturnTime());
+    }
+    return next_time;
+}
+
+Timestamp ZipScheduler::NextZipReturnTime(const Order &order) const
+{
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return nests_[AssignNest(order)].fleet.NextReturnTime();
+}
+
+}  // namespace zipline
@@ -0,0 +1,212 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+// A/B runner for scheduling policies. Replays the same order stream through two schedulers side by side, one per
+// policy, then lists the launch ticks at which their flights differ and compares their delivery KPIs:
+//
+//   ../zip_ab --a=greedy --b=nearest --show=10
+//
+// Any hospitals/orders pair works, including the ones zip_workload writes.
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "delivery_stats.h"
+#include "flight.h"
+#include "hospital.h"
+#include "order.h"
+#include "scheduler_config.h"
+#include "scheduling_policy.h"
+#include "simulation.h"
+#include "zip_scheduler.h"
+
+namespace
+{
+using zipline::Flight;
+using zipline::Order;
+using zipline::Timestamp;
+
+// Flights one policy launched at one tick.
+struct Tick
+{
+    Timestamp time;
+    std::vector<Flight> flights;
+};
+
+// Everything one side of the comparison did.
+struct Run
+{
+    std::vector<Tick> ticks;
+    zipline::DeliveryStats stats;
+};
+
+void Replay(const zipline::HospitalTable &hospitals, const std::vector<Order> &orders,
+            const zipline::SchedulerConfig &config, const zipline::AnyPolicy &policy, Run &run)
+{
+    zipline::ZipScheduler scheduler{hospitals, config};
+    scheduler.set_policy(policy);
+    zipline::Simulation simulation{scheduler, config.time_between_launches};
+    simulation.set_delivery_stats(&run.stats);
+    simulation.set_launch_callback([&run](Timestamp time, const std::vector<Flight> &flights) {
+        if (!flights.empty()) run.ticks.push_back(Tick{time, flights});
+    });
+    simulation.Run(orders, std::numeric_limits<Timestamp>::max());
+}
+
+bool SameOrder(const Order &a, const Order &b)
+{
+    return a.received_time() == b.received_time() && a.hospital_id() == b.hospital_id() &&
+           a.priority() == b.priority();
+}
+
+bool SameFlight(const Flight &a, const Flight &b)
+{
+    return a.nest() == b.nest() && a.zip() == b.zip() && a.num_stops() == b.num_stops() &&
+           std::equal(a.orders().begin(), a.orders().end(), b.orders().begin(), SameOrder);
+}
+
+bool SameFlights(const std::vector<Flight> &a, const std::vector<Flight> &b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), SameFlight);
+}
+
+void PrintFlights(const char *side, const zipline::HospitalTable &hospitals, const std::vector<Flight> &flights)
+{
+    if (flights.empty()) std::printf("  %s: no flights\n", side);
+    for (const auto &flight : flights)
+    {
+        std::printf("  %s: nest %zu zip %d ->", side, flight.nest(), flight.zip());
+        for (const auto &order : flight.orders())
+        {
+            std::printf(" %s(%c)", hospitals.at(order.hospital_id()).name().c_str(),
+                        Order::PriorityToString(order.priority()).front());
+        }
+        std::printf("\n");
+    }
+}
+
+/*
+    Description: Walks both runs' launch ticks in time order and prints the first few at which the flights differ.
+    Returns: The number of ticks at which they differ.
+*/
+size_t DiffTicks(const zipline::HospitalTable &hospitals, const Run &a, const Run &b, size_t max_shown)
+{
+    static const std::vector<Flight> kNoFlights;
+    size_t num_different = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.ticks.size() || j < b.ticks.size())
+    {
+        const Timestamp a_time = i < a.ticks.size() ? a.ticks[i].time : std::numeric_limits<Timestamp>::max();
+        const Timestamp b_time = j < b.ticks.size() ? b.ticks[j].time : std::numeric_limits<Timestamp>::max();
+        const Timestamp time = std::min(a_time, b_time);
+        const auto &a_flights = a_time == time ? a.ticks[i++].flights : kNoFlights;
+        const auto &b_flights = b_time == time ? b.ticks[j++].flights : kNoFlights;
+        if (SameFlights(a_flights, b_flights)) continue;
+
+        if (num_different++ < max_shown)
+        {
+            std::printf("t=%d\n", time);
+            PrintFlights("a", hospitals, a_flights);
+            PrintFlights("b", hospitals, b_flights);
+        }
+    }
+    return num_different;
+}
+
+void PrintKpi(const char *name, double a, double b)
+{
+    std::printf("%-22s %12.1f %12.1f %+12.1f\n", name, a, b, b - a);
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+try
+{
+    std::string_view a_name = zipline::GreedyPolicy::kName;
+    std::string_view b_name = zipline::NearestNeighborPolicy::kName;
+    std::filesystem::path hospitals_file{"../inputs/hospitals.csv"};
+    std::filesystem::path orders_file{"../inputs/orders.csv"};
+    std::filesystem::path nests_file;
+    size_t max_shown = 5;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        const size_t equals = arg.find('=');
+        const std::string_view name = arg.substr(0, equals);
+        const std::string_view value = equals == std::string_view::npos ? std::string_view{} : arg.substr(equals + 1);
+
+        if (name == "--a") a_name = value;
+        else if (name == "--b") b_name = value;
+        else if (name == "--hospitals") hospitals_file = value;
+        else if (name == "--orders") orders_file = value;
+        else if (name == "--nests") nests_file = value;
+        else if (name == "--show") max_shown = std::stoul(std::string(value));
+        else
+        {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    const auto a_policy = zipline::MakePolicy(a_name);
+    const auto b_policy = zipline::MakePolicy(b_name);
+    if (!a_policy || !b_policy)
+    {
+        std::cerr << "Unknown policy " << (a_policy ? b_name : a_name) << "; choose one of:";
+        for (const auto name : zipline::PolicyNames()) std::cerr << " " << name;
+        std::cerr << std::endl;
+        return 1;
+    }
+
+    const zipline::SchedulerConfig config;
+    const auto hospitals = zipline::Hospital::LoadHospitals(hospitals_file, config.zip_speed, nests_file);
+    const auto orders = Order::LoadOrders(orders_file, hospitals);
+
+    const size_t num_zips = config.num_zips * hospitals.num_nests();
+    Run a{{}, zipline::DeliveryStats{num_zips}};
+    Run b{{}, zipline::DeliveryStats{num_zips}};
+    std::thread b_thread{[&] { Replay(hospitals, orders, config, *b_policy, b); }};
+    Replay(hospitals, orders, config, *a_policy, a);
+    b_thread.join();
+
+    std::printf("a: %.*s, b: %.*s, %zu orders\n", static_cast<int>(a_name.size()), a_name.data(),
+                static_cast<int>(b_name.size()), b_name.data(), orders.size());
+    const size_t num_different = DiffTicks(hospitals, a, b, max_shown);
+    std::printf("flights differ at %zu ticks (a launched at %zu ticks, b at %zu)\n\n", num_different, a.ticks.size(),
+                b.ticks.size());
+
+    std::printf("%-22s %12s %12s %12s\n", "", "a", "b", "b - a");
+    for (const auto priority : Order::kPrioritiesByUrgency)
+    {
+        const std::string label = Order::PriorityToString(priority);
+        const auto &a_times = a.stats.delivery_times(priority);
+        const auto &b_times = b.stats.delivery_times(priority);
+        PrintKpi((label + " mean (s)").c_str(), a_times.mean(), b_times.mean());
+        PrintKpi((label + " p95 (s)").c_str(), a_times.Percentile(0.95), b_times.Percentile(0.95));
+        PrintKpi((label + " max (s)").c_str(), a_times.max(), b_times.max());
+    }
+    PrintKpi("Flights", a.stats.num_flights(), b.stats.num_flights());
+    PrintKpi("Distance/package (km)", a.stats.distance_per_package() / 1000, b.stats.distance_per_package() / 1000);
+    PrintKpi("Zip utilization (%)", a.stats.zip_utilization() * 100, b.stats.zip_utilization() * 100);
+    return 0;
+}
+catch (const zipline::ParseError &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
+catch (const std::system_error &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
@@ -0,0 +1,598 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+// Scheduler benchmark suite. Replays synthetic workloads through the scheduler and reports per-call latency
+// percentiles, throughput and heap allocations for every (orders, zips) combination requested:
+//
+//   ../zip_bench --orders=1000,100000 --zips=10,1000 --pattern=bursty
+//   ../zip_bench --orders=100000 --zips=10,100 --policy=lookahead
+//   ../zip_bench --mode=queue --backlog=100,10000,1000000
+//   ../zip_bench --mode=intake --producers=8 --per-producer=100000
+//   ../zip_bench --mode=cancel --backlog=1000,100000
+//   ../zip_bench --mode=nests
+//
+// The default grid is small enough to run on every change; the full 10^3..10^7 orders x 10..10^4 zips grid is
+// selected with --orders=1000,10000,100000,1000000,10000000 --zips=10,100,1000,10000.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "histogram.h"
+#include "hospital.h"
+#include "order.h"
+#include "order_queue.h"
+#include "scheduling_policy.h"
+#include "simulation.h"
+#include "workload.h"
+#include "zip_scheduler.h"
+
+namespace
+{
+std::atomic<uint64_t> g_num_allocations{0};
+}  // namespace
+
+// Every allocation in the process goes through here so the benchmark can report allocations per scheduler call.
+void *operator new(size_t size)
+{
+    g_num_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+using zipline::Histogram;
+using zipline::Order;
+using zipline::Timestamp;
+using Clock = std::chrono::steady_clock;
+
+constexpr auto kTimeBetweenLaunches = zipline::SchedulerConfig{}.time_between_launches;
+constexpr auto kPackagesPerZipHour = 2.5;  // rough delivery capacity of one zip, used to scale the arrival rate
+
+struct Options
+{
+    std::string mode{"scheduler"};
+    std::vector<uint64_t> orders{1000, 10000, 100000};
+    std::vector<uint64_t> zips{10, 100, 1000};
+    std::vector<uint64_t> backlogs{100, 1000, 10000, 100000, 1000000};
+    uint64_t num_producers{8};
+    uint64_t orders_per_producer{100000};
+    zipline::WorkloadConfig workload;
+    double load{0.8};  // arrival rate as a fraction of the fleet's rough delivery capacity
+    zipline::AnyPolicy policy;
+};
+
+struct SchedulerStats
+{
+    Histogram queue_latency;   // (ns) per QueueOrder call
+    Histogram launch_latency;  // (ns) per LaunchFlights call
+    uint64_t queue_allocations{0};
+    uint64_t launch_allocations{0};
+    uint64_t steady_launch_allocations{0};  // over the launches in the second half of the run
+    uint64_t num_steady_launches{0};
+    uint64_t num_flights{0};
+    double wall_seconds{0.0};
+};
+
+std::vector<uint64_t> ParseList(std::string_view list)
+{
+    std::vector<uint64_t> values;
+    while (!list.empty())
+    {
+        const size_t comma = list.find(',');
+        values.push_back(std::stoull(std::string(list.substr(0, comma))));
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+    }
+    return values;
+}
+
+uint64_t ElapsedNs(Clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+Timestamp AlignToLaunchGrid(const Timestamp time)
+{
+    const Timestamp remainder = time % kTimeBetweenLaunches;
+    return remainder == 0 ? time : time + kTimeBetweenLaunches - remainder;
+}
+
+/*
+    Description: Streams num_orders generated orders through a fresh single-nest scheduler, stepping the clock like
+                 Simulation::Run but timing every QueueOrder and LaunchFlights call on its own.
+    Arguments:
+        - hospitals: service area the orders are generated for
+        - workload: arrival pattern; its rate is overridden by the fleet size and load
+        - num_orders: number of orders to replay
+        - num_zips: size of the fleet
+        - load: arrival rate as a fraction of the fleet's rough delivery capacity
+        - policy: scheduling policy
+    Returns: Latency, allocation and throughput figures for the run. Once the first half of the orders has grown
+             the backlog and fleet state to their working size, launches are also counted as steady state.
+*/
+SchedulerStats RunScheduler(const zipline::HospitalTable &hospitals, zipline::WorkloadConfig workload,
+                            const uint64_t num_orders, const uint64_t num_zips, const double load,
+                            const zipline::AnyPolicy &policy)
+{
+    workload.orders_per_hour = load * kPackagesPerZipHour * num_zips;
+    zipline::OrderGenerator generator{workload, hospitals};
+    zipline::SchedulerConfig config;
+    config.num_zips = static_cast<int>(num_zips);
+    zipline::ZipScheduler scheduler{hospitals, config};
+    scheduler.set_policy(policy);
+
+    SchedulerStats stats;
+    std::vector<zipline::Flight> flights;
+    uint64_t num_generated = 1;
+    std::optional<Order> pending_order = generator.Next();
+
+    const auto run_start = Clock::now();
+    Timestamp cur_time = AlignToLaunchGrid(pending_order->received_time());
+    for (;;)
+    {
+        while (pending_order && pending_order->received_time() <= cur_time)
+        {
+            const uint64_t allocations = g_num_allocations.load(std::memory_order_relaxed);
+            const auto start = Clock::now();
+            scheduler.QueueOrder(*pending_order);
+            stats.queue_latency.Record(ElapsedNs(start));
+            stats.queue_allocations += g_num_allocations.load(std::memory_order_relaxed) - allocations;
+
+            pending_order = std::nullopt;
+            if (num_generated < num_orders)
+            {
+                pending_order = generator.Next();
+                num_generated++;
+            }
+        }
+
+        if (scheduler.HasPendingOrders())
+        {
+            const uint64_t allocations = g_num_allocations.load(std::memory_order_relaxed);
+            const auto start = Clock::now();
+            scheduler.LaunchFlights(cur_time, flights);
+            stats.launch_latency.Record(ElapsedNs(start));
+            const uint64_t launch_allocations = g_num_allocations.load(std::memory_order_relaxed) - allocations;
+            stats.launch_allocations += launch_allocations;
+            if (2 * num_generated > num_orders)
+            {
+                stats.steady_launch_allocations += launch_allocations;
+                stats.num_steady_launches++;
+            }
+            stats.num_flights += flights.size();
+        }
+
+        Timestamp next_time = cur_time + kTimeBetweenLaunches;
+        if (!scheduler.HasPendingOrders())
+        {
+            if (!pending_order) break;
+            next_time = std::max(next_time, AlignToLaunchGrid(pending_order->received_time()));
+        }
+        else
+        {
+            Timestamp wake_time = scheduler.NextZipReturnTime();
+            if (pending_order)
+            {
+                const Timestamp launchable_time =
+                    std::max(pending_order->received_time(), scheduler.NextZipReturnTime(*pending_order));
+                wake_time = std::min(wake_time, launchable_time);
+            }
+            next_time = std::max(next_time, AlignToLaunchGrid(wake_time));
+        }
+        cur_time = next_time;
+    }
+    stats.wall_seconds = std::chrono::duration<double>(Clock::now() - run_start).count();
+    return stats;
+}
+
+/*
+    Description: Runs RunScheduler for every (orders, zips) combination and prints one row each. A row fails if its
+                 steady-state launches allocate more than the occasional growth to a new high-water mark.
+    Returns: False if any row failed.
+*/
+bool RunSchedulerGrid(const Options &options)
+{
+    // growing the backlog to a new high-water mark may still allocate now and then
+    constexpr uint64_t kMaxSteadyGrowthAllocations = 8;
+    constexpr double kMaxSteadyAllocationsPerLaunch = 0.01;
+
+    const auto hospitals = zipline::GenerateHospitals(options.workload, zipline::SchedulerConfig{}.zip_speed);
+
+    std::printf("policy: %s\n", std::string(zipline::PolicyName(options.policy)).c_str());
+    std::printf("%10s %6s | %8s %8s %8s | %9s %9s %9s | %7s %8s %8s | %10s %9s | %s\n", "orders", "zips",
+                "q p50 ns", "q p99 ns", "q max ns", "l p50 us", "l p99 us", "l max us", "alloc/q", "alloc/l",
+                "steady/l", "orders/s", "flights", "check");
+    bool all_ok = true;
+    for (const uint64_t num_orders : options.orders)
+    {
+        for (const uint64_t num_zips : options.zips)
+        {
+            const auto stats =
+                RunScheduler(hospitals, options.workload, num_orders, num_zips, options.load, options.policy);
+            const auto &queue = stats.queue_latency;
+            const auto &launch = stats.launch_latency;
+            const double steady_allocations = static_cast<double>(stats.steady_launch_allocations) /
+                                              std::max<uint64_t>(stats.num_steady_launches, 1);
+            const bool ok = stats.steady_launch_allocations <= kMaxSteadyGrowthAllocations ||
+                            steady_allocations <= kMaxSteadyAllocationsPerLaunch;
+            all_ok &= ok;
+            std::printf("%10llu %6llu | %8llu %8llu %8llu | %9.1f %9.1f %9.1f | %7.2f %8.1f %8.3f | %10.0f %9llu "
+                        "| %s\n",
+                        static_cast<unsigned long long>(num_orders), static_cast<unsigned long long>(num_zips),
+                        static_cast<unsigned long long>(queue.Percentile(0.5)),
+                        static_cast<unsigned long long>(queue.Percentile(0.99)),
+                        static_cast<unsigned long long>(queue.max()), launch.Percentile(0.5) / 1e3,
+                        launch.Percentile(0.99) / 1e3, launch.max() / 1e3,
+                        static_cast<double>(stats.queue_allocations) / std::max<uint64_t>(queue.count(), 1),
+                        static_cast<double>(stats.launch_allocations) / std::max<uint64_t>(launch.count(), 1),
+                        steady_allocations, num_orders / stats.wall_seconds,
+                        static_cast<unsigned long long>(stats.num_flights), ok ? "OK" : "FAILED");
+            std::fflush(stdout);
+        }
+    }
+    return all_ok;
+}
+
+/*
+    Description: Measures the order queue on its own at a fixed backlog: every iteration pushes one order and removes
+                 one, alternating between the oldest order and the oldest order for the nearest hospital, so the
+                 per-operation latency can be compared across backlog sizes.
+*/
+void RunQueueBench(const Options &options)
+{
+    constexpr uint64_t kOpsPerBacklog = 200000;
+
+    const auto hospitals = zipline::GenerateHospitals(options.workload, zipline::SchedulerConfig{}.zip_speed);
+    const auto nest = hospitals.nest_id();
+
+    std::printf("%10s | %9s %9s | %9s %9s | %9s %9s | %9s %9s\n", "backlog", "push p50", "push p99", "front p50",
+                "front p99", "near p50", "near p99", "from p50", "from p99");
+    for (const uint64_t backlog : options.backlogs)
+    {
+        zipline::OrderGenerator generator{options.workload, hospitals};
+        zipline::OrderQueue queue{hospitals.size()};
+        queue.Reserve(backlog + 1);
+        for (uint64_t i = 0; i < backlog; ++i) queue.Push(generator.Next());
+
+        std::mt19937_64 rng{options.workload.seed};
+        std::uniform_int_distribution<size_t> random_hospital{0, hospitals.size() - 1};
+        Histogram push, pop_front, nearest, pop_from;
+        for (uint64_t i = 0; i < kOpsPerBacklog; ++i)
+        {
+            const Order order = generator.Next();
+            auto start = Clock::now();
+            queue.Push(order);
+            push.Record(ElapsedNs(start));
+
+            if (i % 2 == 0)
+            {
+                start = Clock::now();
+                queue.PopFront();
+                pop_front.Record(ElapsedNs(start));
+            }
+            else
+            {
+                const auto from = static_cast<zipline::HospitalId>(random_hospital(rng));
+                start = Clock::now();
+                const auto hospital = queue.NearestHospital(hospitals, i % 4 == 1 ? nest : from);
+                nearest.Record(ElapsedNs(start));
+
+                start = Clock::now();
+                queue.PopFrom(*hospital);
+                pop_from.Record(ElapsedNs(start));
+            }
+        }
+
+        std::printf("%10llu | %9llu %9llu | %9llu %9llu | %9llu %9llu | %9llu %9llu\n",
+                    static_cast<unsigned long long>(backlog), static_cast<unsigned long long>(push.Percentile(0.5)),
+                    static_cast<unsigned long long>(push.Percentile(0.99)),
+                    static_cast<unsigned long long>(pop_front.Percentile(0.5)),
+                    static_cast<unsigned long long>(pop_front.Percentile(0.99)),
+                    static_cast<unsigned long long>(nearest.Percentile(0.5)),
+                    static_cast<unsigned long long>(nearest.Percentile(0.99)),
+                    static_cast<unsigned long long>(pop_from.Percentile(0.5)),
+                    static_cast<unsigned long long>(pop_from.Percentile(0.99)));
+        std::fflush(stdout);
+    }
+}
+
+/*
+    Description: Stress check for concurrent intake. Producer threads queue uniquely numbered orders (the hospital
+                 names the producer, the received time its sequence number) into a deliberately small intake ring
+                 while this thread keeps launching flights. Every order must leave on exactly one flight.
+    Returns: True if no order was lost or duplicated.
+*/
+bool RunIntakeStress(const Options &options)
+{
+    const uint64_t num_producers = options.num_producers;
+    const uint64_t per_producer = options.orders_per_producer;
+
+    // hospitals right next to the nest keep zips turning around within a tick or two
+    zipline::WorkloadConfig workload = options.workload;
+    workload.num_hospitals = num_producers;
+    workload.radius = 1000;
+    zipline::SchedulerConfig config;
+    config.num_zips = 1000;
+    config.intake_capacity = 1024;
+    const auto hospitals = zipline::GenerateHospitals(workload, config.zip_speed);
+    zipline::ZipScheduler scheduler{hospitals, config};
+
+    const auto start = Clock::now();
+    std::atomic<uint64_t> num_finished{0};
+    std::vector<std::thread> producers;
+    for (uint64_t p = 0; p < num_producers; ++p)
+    {
+        producers.emplace_back([&scheduler, &num_finished, p, per_producer]() {
+            for (uint64_t seq = 0; seq < per_producer; ++seq)
+            {
+                scheduler.QueueOrder(Order(static_cast<Timestamp>(seq), static_cast<zipline::HospitalId>(p),
+                                           Order::Priority::kEmergency));
+            }
+            num_finished.fetch_add(1, std::memory_order_release);
+        });
+    }
+
+    std::vector<std::vector<uint8_t>> seen(num_producers, std::vector<uint8_t>(per_producer, 0));
+    uint64_t num_delivered = 0;
+    uint64_t num_duplicated = 0;
+    uint64_t num_ticks = 0;
+    for (Timestamp cur_time = 0;; cur_time += kTimeBetweenLaunches)
+    {
+        const bool producers_finished = num_finished.load(std::memory_order_acquire) == num_producers;
+        for (const auto &flight : scheduler.LaunchFlights(cur_time))
+        {
+            for (const auto &order : flight.orders())
+            {
+                auto &delivered = seen[order.hospital_id()][order.received_time()];
+                if (delivered) num_duplicated++;
+                delivered = 1;
+                num_delivered++;
+            }
+        }
+        num_ticks++;
+        if (producers_finished && !scheduler.HasPendingOrders()) break;
+    }
+    for (auto &producer : producers) producer.join();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    uint64_t num_missing = 0;
+    for (const auto &producer_seen : seen) num_missing += std::count(producer_seen.begin(), producer_seen.end(), 0);
+
+    const bool ok = num_missing == 0 && num_duplicated == 0;
+    std::printf("intake: %llu producers x %llu orders, %llu delivered over %llu ticks in %.2f s: %llu missing, %llu "
+                "duplicated: %s\n",
+                static_cast<unsigned long long>(num_producers), static_cast<unsigned long long>(per_producer),
+                static_cast<unsigned long long>(num_delivered), static_cast<unsigned long long>(num_ticks), seconds,
+                static_cast<unsigned long long>(num_missing), static_cast<unsigned long long>(num_duplicated),
+                ok ? "OK" : "FAILED");
+    return ok;
+}
+
+// True if two ticks launched the same flights: from the same nests and zips, with the same stops in the same order.
+bool SameFlights(const std::vector<zipline::Flight> &a, const std::vector<zipline::Flight> &b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const auto &x, const auto &y) {
+        return x.nest() == y.nest() && x.zip() == y.zip() &&
+               std::equal(x.orders().begin(), x.orders().end(), y.orders().begin(), y.orders().end(),
+                          [](const Order &p, const Order &q) {
+                              return p.received_time() == q.received_time() && p.hospital_id() == q.hospital_id() &&
+                                     p.priority() == q.priority();
+                          });
+    });
+}
+
+/*
+    Description: Times cancelling, upgrading and re-dating pending orders by id in a scheduler holding a backlog of
+                 resupply orders, a third of the sampled orders each, then launches every remaining order to check
+                 that cancelled orders never fly, upgraded ones fly as emergencies and nothing else is lost. A copy
+                 resumed from a checkpoint taken after the operations must launch exactly the same flights.
+    Returns: True if every operation and the launched flights agreed with what was asked.
+*/
+bool RunCancelBench(const Options &options)
+{
+    constexpr uint64_t kMaxOpsPerBacklog = 30000;
+
+    // hospitals right next to the nest keep zips turning around within a tick or two
+    zipline::WorkloadConfig workload = options.workload;
+    workload.radius = 1000;
+    zipline::SchedulerConfig config;
+    config.num_zips = 1000;
+    const auto hospitals = zipline::GenerateHospitals(workload, config.zip_speed);
+
+    std::printf("%10s | %9s %9s | %9s %9s | %9s %9s | %s\n", "backlog", "cncl p50", "cncl p99", "upgr p50",
+                "upgr p99", "ddln p50", "ddln p99", "check");
+    bool all_ok = true;
+    for (const uint64_t backlog : options.backlogs)
+    {
+        // an order's received time is its id, so launched orders can be traced back to what was done to them
+        zipline::ZipScheduler scheduler{hospitals, config};
+        std::mt19937_64 rng{workload.seed};
+        std::uniform_int_distribution<size_t> random_hospital{0, hospitals.size() - 1};
+        std::vector<zipline::OrderId> ids(backlog);
+        for (uint64_t i = 0; i < backlog; ++i)
+        {
+            ids[i] = scheduler.QueueOrder(Order(static_cast<Timestamp>(i),
+                                                static_cast<zipline::HospitalId>(random_hospital(rng)),
+                                                Order::Priority::kResupply));
+        }
+        std::shuffle(ids.begin(), ids.end(), rng);
+        scheduler.CancelOrder(backlog);  // an unknown id; drains the intake so it is not timed below
+
+        enum class Action : uint8_t
+        {
+            kNone,
+            kCancelled,
+            kUpgraded
+        };
+        std::vector<Action> actions(backlog, Action::kNone);
+        Histogram cancel, upgrade, deadline;
+        bool ok = true;
+        const uint64_t num_ops = std::min(backlog, kMaxOpsPerBacklog);
+        for (uint64_t i = 0; i < num_ops; ++i)
+        {
+            const zipline::OrderId id = ids[i];
+            auto start = Clock::now();
+            if (i % 3 == 0)
+            {
+                ok &= scheduler.CancelOrder(id);
+                cancel.Record(ElapsedNs(start));
+                ok &= !scheduler.CancelOrder(id);
+                actions[id] = Action::kCancelled;
+            }
+            else if (i % 3 == 1)
+            {
+                ok &= scheduler.ChangePriority(id, Order::Priority::kEmergency);
+                upgrade.Record(ElapsedNs(start));
+                actions[id] = Action::kUpgraded;
+            }
+            else
+            {
+                ok &= scheduler.ChangeDeadline(id, static_cast<Timestamp>(id / 2));
+                deadline.Record(ElapsedNs(start));
+            }
+        }
+
+        std::stringstream checkpoint;
+        scheduler.SaveCheckpoint(checkpoint, zipline::CheckpointInfo{0, backlog});
+        zipline::ZipScheduler resumed{hospitals, config};
+        resumed.LoadCheckpoint(checkpoint);
+
+        std::vector<uint8_t> launched(backlog, 0);
+        for (Timestamp cur_time = 0; scheduler.HasPendingOrders(); cur_time += kTimeBetweenLaunches)
+        {
+            const auto flights = scheduler.LaunchFlights(cur_time);
+            ok &= SameFlights(flights, resumed.LaunchFlights(cur_time));
+            for (const auto &flight : flights)
+            {
+                for (const auto &order : flight.orders())
+                {
+                    const auto id = static_cast<zipline::OrderId>(order.received_time());
+                    const bool upgraded = actions[id] == Action::kUpgraded;
+                    ok &= actions[id] != Action::kCancelled && !launched[id] &&
+                          upgraded == (order.priority() == Order::Priority::kEmergency);
+                    launched[id] = 1;
+                }
+            }
+        }
+        for (uint64_t id = 0; id < backlog; ++id) ok &= launched[id] == (actions[id] != Action::kCancelled);
+        ok &= !scheduler.CancelOrder(ids.front()) && (num_ops < 2 || !scheduler.ChangeDeadline(ids[1], 0)) &&
+              !resumed.HasPendingOrders();
+        all_ok &= ok;
+
+        std::printf("%10llu | %9llu %9llu | %9llu %9llu | %9llu %9llu | %s\n",
+                    static_cast<unsigned long long>(backlog), static_cast<unsigned long long>(cancel.Percentile(0.5)),
+                    static_cast<unsigned long long>(cancel.Percentile(0.99)),
+                    static_cast<unsigned long long>(upgrade.Percentile(0.5)),
+                    static_cast<unsigned long long>(upgrade.Percentile(0.99)),
+                    static_cast<unsigned long long>(deadline.Percentile(0.5)),
+                    static_cast<unsigned long long>(deadline.Percentile(0.99)), ok ? "OK" : "FAILED");
+        std::fflush(stdout);
+    }
+    return all_ok;
+}
+
+/*
+    Description: Regression check for multi-nest runs. One nest's only zip leaves on a long emergency flight with a
+                 second emergency still waiting for it, then an emergency arrives next to the other, idle nest. The
+                 simulation must wake up for that order rather than sleep until the busy nest's zip is back.
+    Returns: True if the idle nest's flight launched at the first tick after its order arrived.
+*/
+bool RunMultiNestCheck()
+{
+    constexpr Timestamp kLateOrderTime = 120;
+
+    zipline::HospitalTable hospitals;
+    const auto north = hospitals.Add("North", 70 * 1000, 0);
+    const auto south = hospitals.Add("South", -70 * 1000, 0);  // too far from North to share a flight
+    const auto east = hospitals.Add("East", 0, 290 * 1000);
+    hospitals.AddNest("West nest", 0, 0);
+    hospitals.AddNest("East nest", 0, 300 * 1000);
+    zipline::SchedulerConfig config;
+    config.num_zips = 1;
+    config.num_zips_reduced_range = 0;
+    hospitals.BuildLegTables(config.zip_speed);
+
+    zipline::ZipScheduler scheduler{hospitals, config};
+    zipline::Simulation simulation{scheduler, config.time_between_launches};
+    std::optional<Timestamp> launch_time;
+    simulation.set_launch_callback([&](const Timestamp time, const std::vector<zipline::Flight> &flights) {
+        for (const auto &flight : flights)
+        {
+            for (const Order &order : flight.orders())
+            {
+                if (order.hospital_id() == east && !launch_time) launch_time = time;
+            }
+        }
+    });
+    const std::vector<Order> orders{Order{0, north, Order::Priority::kEmergency},
+                                    Order{0, south, Order::Priority::kEmergency},
+                                    Order{kLateOrderTime, east, Order::Priority::kEmergency}};
+    simulation.Run(orders, 24 * 60 * 60);
+
+    const bool ok = launch_time == kLateOrderTime;
+    std::printf("nests: order for the idle nest received at %lld launched at %lld: %s\n",
+                static_cast<long long>(kLateOrderTime), static_cast<long long>(launch_time.value_or(-1)),
+                ok ? "OK" : "FAILED");
+    return ok;
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        const size_t equals = arg.find('=');
+        const std::string_view name = arg.substr(0, equals);
+        const std::string value{equals == std::string_view::npos ? std::string_view{} : arg.substr(equals + 1)};
+
+        if (name == "--mode") options.mode = value;
+        else if (name == "--orders") options.orders = ParseList(value);
+        else if (name == "--zips") options.zips = ParseList(value);
+        else if (name == "--backlog") options.backlogs = ParseList(value);
+        else if (name == "--producers") options.num_producers = std::stoull(value);
+        else if (name == "--per-producer") options.orders_per_producer = std::stoull(value);
+        else if (name == "--hospitals") options.workload.num_hospitals = std::stoul(value);
+        else if (name == "--emergency") options.workload.emergency_fraction = std::stod(value);
+        else if (name == "--load") options.load = std::stod(value);
+        else if (name == "--policy" && zipline::MakePolicy(value)) options.policy = *zipline::MakePolicy(value);
+        else if (name == "--seed") options.workload.seed = std::stoull(value);
+        else if (name == "--pattern" && value == "bursty") options.workload.arrivals = zipline::ArrivalPattern::kBursty;
+        else if (name == "--pattern" && value == "poisson") options.workload.arrivals = zipline::ArrivalPattern::kPoisson;
+        else
+        {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    if ((options.mode == "scheduler" || options.mode == "all") && !RunSchedulerGrid(options)) return 1;
+    if (options.mode == "queue" || options.mode == "all") RunQueueBench(options);
+    if ((options.mode == "intake" || options.mode == "all") && !RunIntakeStress(options)) return 1;
+    if ((options.mode == "cancel" || options.mode == "all") && !RunCancelBench(options)) return 1;
+    if ((options.mode == "nests" || options.mode == "all") && !RunMultiNestCheck()) return 1;
+    return 0;
+}
@@ -0,0 +1,385 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+// Monte Carlo evaluation of the scheduling policy. Generates many randomized order days shaped like the real one
+// (same hospitals, operating hours, order rate and emergency share unless overridden), simulates each day on its own
+// scheduler across all cores and reports delivery latency and packages per flight with 95% confidence intervals:
+//
+//   ../zip_evaluate --days=2000
+//   ../zip_evaluate --days=2000 --variant-reduced-zips=0
+//   ../zip_evaluate --days=2000 --variant-policy=nearest
+//   ../zip_evaluate --days=2000 --variant-policy=lookahead --variant-resupply-hold=1200
+//   ../zip_evaluate --days=2000 --variant-batch-moves=32
+//
+// --variant-* options describe a policy change: a different scheduling policy or config knob. The baseline and the
+// variant then fly the same days, and the per-day difference gets its own confidence interval, which is far tighter
+// than comparing two separate runs.
+// Every day's orders come from their own seeded stream, so results do not depend on the thread count.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "delivery_stats.h"
+#include "histogram.h"
+#include "hospital.h"
+#include "order.h"
+#include "scheduler_config.h"
+#include "scheduling_policy.h"
+#include "simulation.h"
+#include "thread_pool.h"
+#include "workload.h"
+#include "zip_scheduler.h"
+
+namespace
+{
+using zipline::Histogram;
+using zipline::Order;
+using zipline::SchedulerConfig;
+using zipline::Timestamp;
+
+constexpr double kZ95 = 1.959964;  // two-sided 95% quantile of the normal distribution
+
+// Outcome of one simulated day for one policy.
+struct DayResult
+{
+    double emergency_mean{0.0};
+    double resupply_mean{0.0};
+    double emergency_p95{0.0};
+    double resupply_p95{0.0};
+    double packages_per_flight{0.0};
+};
+
+// Delivery times of every day a policy flew, pooled.
+struct PooledTimes
+{
+    Histogram emergency;
+    Histogram resupply;
+
+    void Merge(const PooledTimes &other)
+    {
+        emergency.Merge(other.emergency);
+        resupply.Merge(other.resupply);
+    }
+};
+
+// A policy knob that a --variant-<name> option can change.
+struct Knob
+{
+    std::string_view name;
+    std::function<void(SchedulerConfig &, long)> apply;
+};
+
+// Sample mean and the half-width of its 95% confidence interval.
+struct Estimate
+{
+    double mean{0.0};
+    double half_width{0.0};
+};
+
+Estimate Estimate95(const std::vector<double> &samples)
+{
+    Estimate estimate;
+    if (samples.empty()) return estimate;
+    double sum = 0.0;
+    for (const double x : samples) sum += x;
+    estimate.mean = sum / samples.size();
+    if (samples.size() < 2) return estimate;
+
+    double squares = 0.0;
+    for (const double x : samples) squares += (x - estimate.mean) * (x - estimate.mean);
+    estimate.half_width = kZ95 * std::sqrt(squares / (samples.size() - 1) / samples.size());
+    return estimate;
+}
+
+// SplitMix64 finalizer: turns (seed, day) into well-separated seeds for independent per-day streams.
+uint64_t DaySeed(uint64_t seed, uint64_t day)
+{
+    uint64_t z = seed + (day + 1) * 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/*
+    Description: Simulates one randomized day: orders arrive from the day's own stream between start_time and
+                 day_end, and the simulation runs on until every order has been delivered.
+    Arguments:
+        - hospitals: service area
+        - workload: order stream shape; its seed selects the day
+        - day_end: time after which no more orders arrive
+        - config: fleet and batching parameters
+        - policy: scheduling policy
+        - pooled: receives every delivery time of the day
+    Returns: The day's latency summary.
+*/
+DayResult SimulateDay(const zipline::HospitalTable &hospitals, const zipline::WorkloadConfig &workload,
+                      const Timestamp day_end, const SchedulerConfig &config, const zipline::AnyPolicy &policy,
+                      PooledTimes &pooled)
+{
+    zipline::OrderGenerator generator{workload, hospitals};
+    const zipline::Simulation::OrderSource next_order = [&generator, day_end]() -> std::optional<Order> {
+        Order order = generator.Next();
+        if (order.received_time() >= day_end) return std::nullopt;
+        return order;
+    };
+
+    zipline::ZipScheduler scheduler{hospitals, config};
+    scheduler.set_policy(policy);
+    zipline::DeliveryStats stats{config.num_zips * hospitals.num_nests()};
+    zipline::Simulation simulation{scheduler, config.time_between_launches};
+    simulation.set_delivery_stats(&stats);
+    simulation.Run(next_order, std::numeric_limits<Timestamp>::max());
+
+    const auto &emergency = stats.delivery_times(Order::Priority::kEmergency);
+    const auto &resupply = stats.delivery_times(Order::Priority::kResupply);
+    pooled.emergency.Merge(emergency);
+    pooled.resupply.Merge(resupply);
+
+    DayResult result;
+    result.emergency_mean = emergency.mean();
+    result.resupply_mean = resupply.mean();
+    result.emergency_p95 = static_cast<double>(emergency.Percentile(0.95));
+    result.resupply_p95 = static_cast<double>(resupply.Percentile(0.95));
+    if (stats.num_flights() > 0)
+    {
+        result.packages_per_flight = static_cast<double>(stats.num_packages()) / stats.num_flights();
+    }
+    return result;
+}
+
+template <typename Field>
+std::vector<double> Collect(const std::vector<DayResult> &days, Field field)
+{
+    std::vector<double> values;
+    values.reserve(days.size());
+    for (const auto &day : days) values.push_back(day.*field);
+    return values;
+}
+
+template <typename Field>
+std::vector<double> CollectDifference(const std::vector<DayResult> &variant, const std::vector<DayResult> &baseline,
+                                      Field field)
+{
+    std::vector<double> values;
+    values.reserve(variant.size());
+    for (size_t i = 0; i < variant.size(); ++i) values.push_back(variant[i].*field - baseline[i].*field);
+    return values;
+}
+
+void PrintRow(const char *label, const Estimate &mean, const Estimate &p95, const Histogram *pooled)
+{
+    std::printf("%-22s %8.1f ± %6.1f   %8.1f ± %6.1f", label, mean.mean, mean.half_width, p95.mean, p95.half_width);
+    if (pooled)
+    {
+        std::printf("   %7llu %7llu %7llu", static_cast<unsigned long long>(pooled->Percentile(0.5)),
+                    static_cast<unsigned long long>(pooled->Percentile(0.99)),
+                    static_cast<unsigned long long>(pooled->max()));
+    }
+    std::printf("\n");
+}
+
+void PrintPackagesRow(const Estimate &packages)
+{
+    std::printf("%-22s %8.3f ± %6.3f\n", "  Packages/flight", packages.mean, packages.half_width);
+}
+
+void PrintPolicy(const char *name, const std::vector<DayResult> &days, const PooledTimes &pooled)
+{
+    std::printf("%s\n", name);
+    PrintRow("  Emergency", Estimate95(Collect(days, &DayResult::emergency_mean)),
+             Estimate95(Collect(days, &DayResult::emergency_p95)), &pooled.emergency);
+    PrintRow("  Resupply", Estimate95(Collect(days, &DayResult::resupply_mean)),
+             Estimate95(Collect(days, &DayResult::resupply_p95)), &pooled.resupply);
+    PrintPackagesRow(Estimate95(Collect(days, &DayResult::packages_per_flight)));
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+try
+{
+    const std::vector<Knob> knobs{
+        {"--variant-zips", [](SchedulerConfig &c, long v) { c.num_zips = static_cast<int>(v); }},
+        {"--variant-range", [](SchedulerConfig &c, long v) { c.max_range = static_cast<int>(v); }},
+        {"--variant-packages", [](SchedulerConfig &c, long v) { c.max_packages = static_cast<int>(v); }},
+        {"--variant-min-resupply",
+         [](SchedulerConfig &c, long v) { c.tier(Order::Priority::kResupply).min_batch = static_cast<size_t>(v); }},
+        {"--variant-max-wait",
+         [](SchedulerConfig &c, long v) { c.tier(Order::Priority::kResupply).time_to_deadline = static_cast<int>(v); }},
+        {"--variant-reduced-zips", [](SchedulerConfig &c, long v) { c.num_zips_reduced_range = static_cast<int>(v); }},
+        {"--variant-launch-interval",
+         [](SchedulerConfig &c, long v) { c.time_between_launches = static_cast<int>(v); }},
+        {"--variant-emergency-hold",
+         [](SchedulerConfig &c, long v) {
+             c.lookahead.max_hold[static_cast<size_t>(Order::Priority::kEmergency)] = v;
+         }},
+        {"--variant-resupply-hold",
+         [](SchedulerConfig &c, long v) {
+             c.lookahead.max_hold[static_cast<size_t>(Order::Priority::kResupply)] = v;
+         }},
+        {"--variant-rate-window", [](SchedulerConfig &c, long v) { c.lookahead.rate_time_constant = v; }},
+        {"--variant-batch-moves",
+         [](SchedulerConfig &c, long v) { c.batch_planning.max_moves = static_cast<size_t>(v); }},
+    };
+    std::filesystem::path hospitals_file{"../inputs/hospitals.csv"};
+    std::filesystem::path orders_file{"../inputs/orders.csv"};
+    std::filesystem::path nests_file;
+    size_t num_days = 1000;
+    size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    zipline::WorkloadConfig workload;
+    std::optional<double> orders_per_hour;
+    std::optional<double> emergency_fraction;
+    std::optional<Timestamp> day_start;
+    std::optional<Timestamp> day_length;
+    const SchedulerConfig baseline;
+    SchedulerConfig variant;
+    zipline::AnyPolicy baseline_policy;
+    std::optional<zipline::AnyPolicy> variant_policy;  // the baseline's unless --variant-policy is given
+    bool has_variant = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        const size_t equals = arg.find('=');
+        const std::string_view name = arg.substr(0, equals);
+        const std::string value{equals == std::string_view::npos ? std::string_view{} : arg.substr(equals + 1)};
+
+        auto knob = std::find_if(knobs.begin(), knobs.end(), [name](const Knob &k) { return k.name == name; });
+        if (knob != knobs.end())
+        {
+            knob->apply(variant, std::stol(value));
+            has_variant = true;
+        }
+        else if (name == "--policy" || name == "--variant-policy")
+        {
+            const auto policy = zipline::MakePolicy(value);
+            if (!policy)
+            {
+                std::cerr << "Unknown policy " << value << "; choose one of:";
+                for (const auto policy_name : zipline::PolicyNames()) std::cerr << " " << policy_name;
+                std::cerr << std::endl;
+                return 1;
+            }
+            if (name == "--policy") baseline_policy = *policy;
+            else variant_policy = policy;
+        }
+        else if (name == "--days") num_days = std::stoul(value);
+        else if (name == "--seed") workload.seed = std::stoull(value);
+        else if (name == "--threads") num_threads = std::max(1ul, std::stoul(value));
+        else if (name == "--rate") orders_per_hour = std::stod(value);
+        else if (name == "--emergency") emergency_fraction = std::stod(value);
+        else if (name == "--start") day_start = std::stoi(value);
+        else if (name == "--length") day_length = std::stoi(value);
+        else if (name == "--pattern" && value == "bursty") workload.arrivals = zipline::ArrivalPattern::kBursty;
+        else if (name == "--pattern" && value == "poisson") workload.arrivals = zipline::ArrivalPattern::kPoisson;
+        else if (name == "--hospitals") hospitals_file = value;
+        else if (name == "--orders") orders_file = value;
+        else if (name == "--nests") nests_file = value;
+        else
+        {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    baseline.Validate();
+    variant.Validate();
+    has_variant = has_variant || variant_policy;
+
+    // shape the randomized days like the recorded one unless told otherwise
+    const auto hospitals = zipline::Hospital::LoadHospitals(hospitals_file, baseline.zip_speed, nests_file);
+    const auto recorded = Order::LoadOrders(orders_file, hospitals);
+    if (recorded.empty() && (!orders_per_hour || !emergency_fraction || !day_start || !day_length))
+    {
+        std::cerr << "No recorded orders to shape the days after; pass --rate, --emergency, --start and --length"
+                  << std::endl;
+        return 1;
+    }
+    const Timestamp recorded_start = recorded.empty() ? 0 : recorded.front().received_time();
+    const Timestamp recorded_length =
+        recorded.empty() ? 0 : std::max<Timestamp>(1, recorded.back().received_time() - recorded_start);
+    const auto num_emergency = std::count_if(recorded.begin(), recorded.end(), [](const Order &order) {
+        return order.priority() == Order::Priority::kEmergency;
+    });
+    workload.start_time = day_start.value_or(recorded_start);
+    const Timestamp day_end = workload.start_time + day_length.value_or(recorded_length);
+    workload.orders_per_hour = orders_per_hour.value_or(recorded.size() * 3600.0 / recorded_length);
+    workload.emergency_fraction =
+        emergency_fraction.value_or(recorded.empty() ? 0.0 : static_cast<double>(num_emergency) / recorded.size());
+
+    const auto start = std::chrono::steady_clock::now();
+    const size_t num_policies = has_variant ? 2 : 1;
+    const SchedulerConfig *configs[] = {&baseline, &variant};
+    const zipline::AnyPolicy *policies[] = {&baseline_policy, variant_policy ? &*variant_policy : &baseline_policy};
+    std::vector<std::vector<DayResult>> results(num_policies, std::vector<DayResult>(num_days));
+
+    // days are handed out in chunks so each chunk pools into its own histograms without locking
+    const size_t num_chunks = std::min(num_days, num_threads * 8);
+    std::vector<std::vector<PooledTimes>> chunk_times(num_policies, std::vector<PooledTimes>(num_chunks));
+    zipline::ThreadPool thread_pool{num_threads - 1};
+    thread_pool.ParallelFor(num_chunks, [&](size_t chunk) {
+        for (size_t day = chunk; day < num_days; day += num_chunks)
+        {
+            zipline::WorkloadConfig day_workload = workload;
+            day_workload.seed = DaySeed(workload.seed, day);
+            for (size_t p = 0; p < num_policies; ++p)
+            {
+                results[p][day] =
+                    SimulateDay(hospitals, day_workload, day_end, *configs[p], *policies[p], chunk_times[p][chunk]);
+            }
+        }
+    });
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%zu days, orders %d..%d at %.1f/h, %.0f%% emergency, seed %llu\n", num_days, workload.start_time,
+                day_end, workload.orders_per_hour, workload.emergency_fraction * 100,
+                static_cast<unsigned long long>(workload.seed));
+    const std::string_view policy_names[] = {zipline::PolicyName(*policies[0]), zipline::PolicyName(*policies[1])};
+    std::printf("%-22s %17s   %17s   %7s %7s %7s\n", "latency (s), 95% CI", "daily mean", "daily p95", "p50",
+                "p99", "max");
+    const char *names[] = {"Baseline", "Variant"};
+    for (size_t p = 0; p < num_policies; ++p)
+    {
+        PooledTimes pooled;
+        for (const auto &times : chunk_times[p]) pooled.Merge(times);
+        const std::string name = std::string(names[p]) + " (" + std::string(policy_names[p]) + ")";
+        PrintPolicy(name.c_str(), results[p], pooled);
+    }
+    if (has_variant)
+    {
+        std::printf("Variant - baseline (paired by day)\n");
+        PrintRow("  Emergency", Estimate95(CollectDifference(results[1], results[0], &DayResult::emergency_mean)),
+                 Estimate95(CollectDifference(results[1], results[0], &DayResult::emergency_p95)), nullptr);
+        PrintRow("  Resupply", Estimate95(CollectDifference(results[1], results[0], &DayResult::resupply_mean)),
+                 Estimate95(CollectDifference(results[1], results[0], &DayResult::resupply_p95)), nullptr);
+        PrintPackagesRow(Estimate95(CollectDifference(results[1], results[0], &DayResult::packages_per_flight)));
+    }
+    std::cerr << num_days * num_policies << " simulations in " << seconds << " s on " << num_threads << " threads"
+              << std::endl;
+    return 0;
+}
+catch (const zipline::ParseError &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
+catch (const std::system_error &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
+catch (const std::invalid_argument &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
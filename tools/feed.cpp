@@ -0,0 +1,81 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+// Order feed for the scheduler's streaming mode. Replays an orders.csv to stdout, writing each order when its
+// received time comes up on a clock running --speed times faster than real time:
+//
+//   ../zip_feed --speed=600 | ../zip_scheduler --stream=- --speed=600
+//
+// or through a FIFO, with the scheduler started first:
+//
+//   mkfifo /tmp/orders && ../zip_scheduler --stream=/tmp/orders --speed=600 & ../zip_feed --speed=600 > /tmp/orders
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include "csv_reader.h"
+#include "hospital.h"
+#include "order.h"
+#include "scheduler_config.h"
+
+int main(int argc, char **argv)
+try
+{
+    std::filesystem::path hospitals_file{"../inputs/hospitals.csv"};
+    std::filesystem::path orders_file{"../inputs/orders.csv"};
+    double speedup = 1.0;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        const size_t equals = arg.find('=');
+        const std::string_view name = arg.substr(0, equals);
+        const std::string value{equals == std::string_view::npos ? std::string_view{} : arg.substr(equals + 1)};
+
+        if (name == "--hospitals") hospitals_file = value;
+        else if (name == "--orders") orders_file = value;
+        else if (name == "--speed") speedup = std::stod(value);
+        else
+        {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (!(speedup > 0))
+    {
+        std::cerr << "--speed must be positive" << std::endl;
+        return 1;
+    }
+
+    const auto hospitals = zipline::Hospital::LoadHospitals(hospitals_file, zipline::SchedulerConfig{}.zip_speed);
+    zipline::OrderReader orders{orders_file, hospitals};
+    const auto wall_start = std::chrono::steady_clock::now();
+    std::optional<zipline::Timestamp> start_time;
+    for (const auto &order : orders)
+    {
+        if (!start_time) start_time = order.received_time();
+        const std::chrono::duration<double> offset{(order.received_time() - *start_time) / speedup};
+        std::this_thread::sleep_until(wall_start +
+                                      std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+
+        // flushed line by line so the scheduler sees every order as soon as it is due
+        std::cout << order.received_time() << ", " << hospitals.at(order.hospital_id()).name() << ", "
+                  << zipline::Order::PriorityToString(order.priority()) << std::endl;
+        if (!std::cout) return 1;  // the scheduler went away
+    }
+    return 0;
+}
+catch (const zipline::ParseError &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
+catch (const std::system_error &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
@@ -0,0 +1,71 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+// Writes a synthetic hospitals.csv and orders.csv in the same format as inputs/, so generated workloads can be fed to
+// the scheduler binary unchanged:
+//
+//   ../zip_workload --out=/tmp/workload --hospitals=200 --orders=100000 --rate=120 --pattern=bursty
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "order.h"
+#include "workload.h"
+#include "zip_scheduler.h"
+
+int main(int argc, char **argv)
+{
+    zipline::WorkloadConfig config;
+    std::filesystem::path out_dir{"."};
+    size_t num_orders = 1000;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        const size_t equals = arg.find('=');
+        const std::string_view name = arg.substr(0, equals);
+        const std::string value{equals == std::string_view::npos ? std::string_view{} : arg.substr(equals + 1)};
+
+        if (name == "--out") out_dir = value;
+        else if (name == "--orders") num_orders = std::stoul(value);
+        else if (name == "--hospitals") config.num_hospitals = std::stoul(value);
+        else if (name == "--radius") config.radius = std::stoi(value);
+        else if (name == "--rate") config.orders_per_hour = std::stod(value);
+        else if (name == "--emergency") config.emergency_fraction = std::stod(value);
+        else if (name == "--start") config.start_time = std::stoi(value);
+        else if (name == "--seed") config.seed = std::stoull(value);
+        else if (name == "--pattern" && value == "bursty") config.arrivals = zipline::ArrivalPattern::kBursty;
+        else if (name == "--pattern" && value == "poisson") config.arrivals = zipline::ArrivalPattern::kPoisson;
+        else
+        {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    const auto hospitals = zipline::GenerateHospitals(config, zipline::SchedulerConfig{}.zip_speed);
+    std::filesystem::create_directories(out_dir);
+
+    std::ofstream hospitals_file{out_dir / "hospitals.csv"};
+    for (const auto &hospital : hospitals)
+    {
+        hospitals_file << hospital.name() << ", " << hospital.north() << ", " << hospital.east() << "\n";
+    }
+
+    std::ofstream orders_file{out_dir / "orders.csv"};
+    zipline::OrderGenerator generator{config, hospitals};
+    for (size_t i = 0; i < num_orders; ++i)
+    {
+        const auto order = generator.Next();
+        orders_file << order.received_time() << ", " << hospitals.at(order.hospital_id()).name() << ", "
+                    << zipline::Order::PriorityToString(order.priority()) << "\n";
+    }
+
+    if (!hospitals_file || !orders_file)
+    {
+        std::cerr << "Failed to write workload to " << out_dir << std::endl;
+        return 1;
+    }
+    return 0;
+}
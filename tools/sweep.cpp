@@ -0,0 +1,229 @@
+// Copyright 2021 Zipline International Inc. All rights reserved.
+
+// Parameter sweep over scheduler configs. Every combination of the listed values is simulated against the same
+// hospitals and orders, independent simulations running across all cores, and one results row is printed per config:
+//
+//   ../zip_sweep --zips=4,6,8,10,12 --range=120000,160000 --packages=1,2,3 --format=csv
+//
+// Parameters that are not listed keep their SchedulerConfig default.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "delivery_stats.h"
+#include "hospital.h"
+#include "order.h"
+#include "scheduler_config.h"
+#include "simulation.h"
+#include "thread_pool.h"
+#include "zip_scheduler.h"
+
+namespace
+{
+using zipline::Order;
+using zipline::SchedulerConfig;
+
+// One config's outcome, kept small so sweeps of many thousands of configs stay cheap to hold.
+struct SweepResult
+{
+    double emergency_mean{0.0};
+    uint64_t emergency_p50{0};
+    uint64_t emergency_p95{0};
+    uint64_t emergency_max{0};
+    double resupply_mean{0.0};
+    uint64_t resupply_p95{0};
+    uint64_t num_flights{0};
+    double zip_utilization{0.0};
+    double distance_per_package{0.0};
+};
+
+// A swept parameter: its command line name and where its values go in the config.
+struct Axis
+{
+    std::string_view name;
+    std::function<void(SchedulerConfig &, long)> apply;
+    std::vector<long> values;
+};
+
+std::vector<long> ParseList(std::string_view list)
+{
+    std::vector<long> values;
+    while (!list.empty())
+    {
+        const size_t comma = list.find(',');
+        values.push_back(std::stol(std::string(list.substr(0, comma))));
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+    }
+    return values;
+}
+
+// Cartesian product of every axis; the last axis varies fastest.
+std::vector<SchedulerConfig> ExpandGrid(const std::vector<Axis> &axes)
+{
+    std::vector<SchedulerConfig> configs{SchedulerConfig{}};
+    for (const auto &axis : axes)
+    {
+        if (axis.values.empty()) continue;
+        std::vector<SchedulerConfig> expanded;
+        expanded.reserve(configs.size() * axis.values.size());
+        for (const auto &config : configs)
+        {
+            for (const long value : axis.values)
+            {
+                expanded.push_back(config);
+                axis.apply(expanded.back(), value);
+            }
+        }
+        configs = std::move(expanded);
+    }
+    return configs;
+}
+
+SweepResult RunConfig(const zipline::HospitalTable &hospitals, const std::vector<Order> &orders,
+                      const SchedulerConfig &config)
+{
+    zipline::ZipScheduler scheduler{hospitals, config};
+    zipline::DeliveryStats stats{config.num_zips * hospitals.num_nests()};
+    zipline::Simulation simulation{scheduler, config.time_between_launches};
+    simulation.set_delivery_stats(&stats);
+    simulation.Run(orders, std::numeric_limits<zipline::Timestamp>::max());
+
+    const auto &emergency = stats.delivery_times(Order::Priority::kEmergency);
+    const auto &resupply = stats.delivery_times(Order::Priority::kResupply);
+    SweepResult result;
+    result.emergency_mean = emergency.mean();
+    result.emergency_p50 = emergency.Percentile(0.5);
+    result.emergency_p95 = emergency.Percentile(0.95);
+    result.emergency_max = emergency.max();
+    result.resupply_mean = resupply.mean();
+    result.resupply_p95 = resupply.Percentile(0.95);
+    result.num_flights = stats.num_flights();
+    result.zip_utilization = stats.zip_utilization();
+    result.distance_per_package = stats.distance_per_package();
+    return result;
+}
+
+void PrintResults(const std::vector<SchedulerConfig> &configs, const std::vector<SweepResult> &results, bool csv)
+{
+    const char *header_format = csv ? "%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s\n"
+                                    : "%5s %6s %4s %5s %6s %6s %5s %6s | %8s %6s %6s %6s | %8s %6s | %7s %6s %7s\n";
+    const char *row_format = csv ? "%d,%d,%d,%d,%zu,%d,%d,%d,%.1f,%llu,%llu,%llu,%.1f,%llu,%llu,%.3f,%.2f\n"
+                                 : "%5d %6d %4d %5d %6zu %6d %5d %6d | %8.1f %6llu %6llu %6llu | %8.1f %6llu | %7llu "
+                                   "%6.3f %7.2f\n";
+    if (csv)
+    {
+        std::printf(header_format, "zips", "range_m", "pkgs", "speed", "min_resupply", "max_wait_s", "reduced_zips",
+                    "launch_s", "emergency_mean_s", "emergency_p50_s", "emergency_p95_s", "emergency_max_s",
+                    "resupply_mean_s", "resupply_p95_s", "flights", "utilization", "km_per_package");
+    }
+    else
+    {
+        std::printf(header_format, "zips", "range", "pkgs", "speed", "minrs", "wait", "rzips", "launch", "em mean",
+                    "em p50", "em p95", "em max", "rs mean", "rs p95", "flights", "util", "km/pkg");
+    }
+
+    for (size_t i = 0; i < configs.size(); ++i)
+    {
+        const auto &config = configs[i];
+        const auto &result = results[i];
+        std::printf(row_format, config.num_zips, config.max_range, config.max_packages, config.zip_speed,
+                    config.tier(Order::Priority::kResupply).min_batch,
+                    static_cast<int>(config.tier(Order::Priority::kResupply).time_to_deadline),
+                    config.num_zips_reduced_range, static_cast<int>(config.time_between_launches),
+                    result.emergency_mean, static_cast<unsigned long long>(result.emergency_p50),
+                    static_cast<unsigned long long>(result.emergency_p95),
+                    static_cast<unsigned long long>(result.emergency_max), result.resupply_mean,
+                    static_cast<unsigned long long>(result.resupply_p95),
+                    static_cast<unsigned long long>(result.num_flights), result.zip_utilization,
+                    result.distance_per_package / 1000);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv)
+try
+{
+    std::vector<Axis> axes{
+        {"--zips", [](SchedulerConfig &c, long v) { c.num_zips = static_cast<int>(v); }, {}},
+        {"--range", [](SchedulerConfig &c, long v) { c.max_range = static_cast<int>(v); }, {}},
+        {"--packages", [](SchedulerConfig &c, long v) { c.max_packages = static_cast<int>(v); }, {}},
+        {"--speed", [](SchedulerConfig &c, long v) { c.zip_speed = static_cast<int>(v); }, {}},
+        {"--min-resupply",
+         [](SchedulerConfig &c, long v) { c.tier(Order::Priority::kResupply).min_batch = static_cast<size_t>(v); },
+         {}},
+        {"--max-wait",
+         [](SchedulerConfig &c, long v) { c.tier(Order::Priority::kResupply).time_to_deadline = static_cast<int>(v); },
+         {}},
+        {"--reduced-zips", [](SchedulerConfig &c, long v) { c.num_zips_reduced_range = static_cast<int>(v); }, {}},
+        {"--launch-interval", [](SchedulerConfig &c, long v) { c.time_between_launches = static_cast<int>(v); }, {}},
+    };
+    std::filesystem::path hospitals_file{"../inputs/hospitals.csv"};
+    std::filesystem::path orders_file{"../inputs/orders.csv"};
+    std::filesystem::path nests_file;
+    size_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+    bool csv = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+        const size_t equals = arg.find('=');
+        const std::string_view name = arg.substr(0, equals);
+        const std::string value{equals == std::string_view::npos ? std::string_view{} : arg.substr(equals + 1)};
+
+        auto axis = std::find_if(axes.begin(), axes.end(), [name](const Axis &a) { return a.name == name; });
+        if (axis != axes.end()) axis->values = ParseList(value);
+        else if (name == "--hospitals") hospitals_file = value;
+        else if (name == "--orders") orders_file = value;
+        else if (name == "--nests") nests_file = value;
+        else if (name == "--threads") num_threads = std::max(1ul, std::stoul(value));
+        else if (name == "--format") csv = value == "csv";
+        else
+        {
+            std::cerr << "Unknown argument " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // only the leg distances are used for planning, so one table serves every zip speed in the grid
+    const auto hospitals = zipline::Hospital::LoadHospitals(hospitals_file, SchedulerConfig{}.zip_speed, nests_file);
+    const auto orders = Order::LoadOrders(orders_file, hospitals);
+    const auto configs = ExpandGrid(axes);
+    for (const auto &config : configs) config.Validate();
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<SweepResult> results(configs.size());
+    zipline::ThreadPool thread_pool{num_threads - 1};
+    thread_pool.ParallelFor(configs.size(),
+                            [&](size_t i) { results[i] = RunConfig(hospitals, orders, configs[i]); });
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    PrintResults(configs, results, csv);
+    std::cerr << configs.size() << " configs in " << seconds << " s on " << num_threads << " threads" << std::endl;
+    return 0;
+}
+catch (const zipline::ParseError &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
+catch (const std::system_error &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}
+catch (const std::invalid_argument &error)
+{
+    std::cerr << error.what() << std::endl;
+    return 1;
+}